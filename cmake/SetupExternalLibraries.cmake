@@ -27,6 +27,11 @@ else()
     find_package(OpenGL 4.1 REQUIRED)
 endif()
 
+# ---------------------------------------------------------------------------------
+# Find Threads
+# ---------------------------------------------------------------------------------
+find_package(Threads REQUIRED)
+
 # ---------------------------------------------------------------------------------
 # Download or retrieve glfw
 # ---------------------------------------------------------------------------------
@@ -0,0 +1,6 @@
+#version 410
+
+// Only used by occlusion queries, with color writes disabled
+
+void main() {
+}
@@ -0,0 +1,21 @@
+#version 410
+
+layout (location = 0) in vec3 a_position; // Unit cube corner
+
+uniform vec3 u_boundsMin;
+uniform vec3 u_boundsMax;
+
+layout (std140) uniform FrameUniforms {
+    mat4 u_projection;
+    mat4 u_view;
+    mat4 u_projectionView;
+    vec4 u_cameraPosition;
+    vec4 u_lightPosition;
+    vec4 u_lightColor;
+    vec4 u_ambientColor; // a is the ambient factor
+    float u_time;
+};
+
+void main() {
+    gl_Position = u_projectionView * vec4(mix(u_boundsMin, u_boundsMax, a_position), 1.0f);
+}
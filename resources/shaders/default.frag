@@ -14,12 +14,23 @@ layout (location = 3) in vec2 v_texCoord0;
 layout (location = 0) out vec4 o_fragColor;
 
 uniform sampler2D u_baseColorTexture;
-uniform vec4 u_baseColorFactor;
 
-const vec3 c_lightPos = vec3(-500, 500, -250);
-const vec3 c_lightColor = vec3(1, 1, 1);
-const vec3 c_ambientColor = vec3(1, 1, 1);
-const float c_ambientFactor = 0.5f;
+layout (std140) uniform FrameUniforms {
+    mat4 u_projection;
+    mat4 u_view;
+    mat4 u_projectionView;
+    vec4 u_cameraPosition;
+    vec4 u_lightPosition;
+    vec4 u_lightColor;
+    vec4 u_ambientColor; // a is the ambient factor
+    float u_time;
+};
+
+layout (std140) uniform DrawUniforms {
+    mat4 u_transform; // Unused by instanced variants
+    vec4 u_baseColorFactor;
+    float u_normalScale;
+};
 
 void main() {
     vec4 baseColor = texture(u_baseColorTexture, v_texCoord0) * u_baseColorFactor;
@@ -35,9 +46,9 @@ void main() {
     }
 
     vec3 norm = gl_FrontFacing ? normalize(v_normal) : -normalize(v_normal);
-    vec3 lightDir = normalize(c_lightPos - v_position);
+    vec3 lightDir = normalize(u_lightPosition.xyz - v_position);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * c_lightColor;
+    vec3 diffuse = diff * u_lightColor.rgb;
 
-    o_fragColor = vec4(((c_ambientColor * c_ambientFactor) + diffuse), 1) * baseColor;
+    o_fragColor = vec4(((u_ambientColor.rgb * u_ambientColor.a) + diffuse), 1) * baseColor;
 }
@@ -1,13 +1,20 @@
 #version 410
 
 layout (location = 0) in vec3 a_position;
+#if defined HAS_OCTAHEDRAL_NORMALS
+layout (location = 1) in vec2 a_normal;
+#else
 layout (location = 1) in vec3 a_normal;
+#endif
 #if defined HAS_VEC3_COLORS
 layout (location = 2) in vec3 a_color0;
 #elif defined HAS_VEC4_COLORS
 layout (location = 2) in vec4 a_color0;
 #endif
 layout (location = 3) in vec2 a_texCoord0;
+#if defined HAS_INSTANCE_TRANSFORMS
+layout (location = 4) in mat4 a_instanceTransform;
+#endif
 
 layout (location = 0) out vec3 v_position;
 #if defined HAS_VEC3_COLORS
@@ -18,19 +25,52 @@ layout (location = 1) out vec4 v_color0;
 layout (location = 2) out vec3 v_normal;
 layout (location = 3) out vec2 v_texCoord0;
 
-uniform mat4 u_projectionView;
-uniform mat4 u_transform;
+layout (std140) uniform FrameUniforms {
+    mat4 u_projection;
+    mat4 u_view;
+    mat4 u_projectionView;
+    vec4 u_cameraPosition;
+    vec4 u_lightPosition;
+    vec4 u_lightColor;
+    vec4 u_ambientColor; // a is the ambient factor
+    float u_time;
+};
+
+layout (std140) uniform DrawUniforms {
+    mat4 u_transform; // Unused by instanced variants
+    vec4 u_baseColorFactor;
+    float u_normalScale;
+};
+
+#if defined HAS_OCTAHEDRAL_NORMALS
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    float fold = max(-n.z, 0.0f);
+    n.xy += vec2(n.x >= 0.0f ? -fold : fold, n.y >= 0.0f ? -fold : fold);
+    return normalize(n);
+}
+#endif
 
 void main() {
-    gl_Position = u_projectionView * u_transform * vec4(a_position, 1.0f);
+#if defined HAS_INSTANCE_TRANSFORMS
+    mat4 transform = a_instanceTransform;
+#else
+    mat4 transform = u_transform;
+#endif
+
+    gl_Position = u_projectionView * transform * vec4(a_position, 1.0f);
     v_position = gl_Position.xyz;
 
 #if defined HAS_VEC3_COLORS || defined HAS_VEC4_COLORS
     v_color0 = a_color0;
 #endif
 
-    mat3 normalMatrix = transpose(inverse(mat3(u_transform))); // TODO pass normal matrix as argument ?
+    mat3 normalMatrix = transpose(inverse(mat3(transform))); // TODO pass normal matrix as argument ?
+#if defined HAS_OCTAHEDRAL_NORMALS
+    v_normal = normalize(normalMatrix * decodeOctahedral(a_normal));
+#else
     v_normal = normalize(normalMatrix * a_normal);
+#endif
 
     v_texCoord0 = a_texCoord0;
 }
@@ -2,44 +2,151 @@
 // Created by Simon Cros on 29/01/2025.
 //
 
+#include <algorithm>
+
 #include "Animator.h"
 #include "Engine/Mesh.h"
 
-Animator::Animator(Object& object, const Mesh& mesh): EngineComponent(object), m_mesh(mesh)
+Animator::Animator(Object& object, const Mesh& mesh): EngineComponent(object), m_mesh(mesh), m_pose(mesh.restPose())
 {
-    m_nodeTransforms.resize(mesh.model().nodes.size());
+}
+
+Animator::~Animator()
+{
+    if (m_group == nullptr)
+        return;
+
+    std::erase(m_group->animators, this);
+    if (m_group->animators.empty())
+        m_engine->releaseAnimatorGroup(m_mesh);
+}
+
+void Animator::onWillUpdate(Engine& engine)
+{
+    if (m_group != nullptr)
+        return;
+
+    m_engine = &engine;
+    m_group = &engine.animatorGroup(m_mesh);
+    m_group->animators.push_back(this);
 }
 
 void Animator::onUpdate(Engine& engine)
+{
+    // Offset by one so that the first frame (frameCount 0) is not seen as already updated
+    const uint64_t frame = engine.frameInfo().frameCount + 1;
+    if (m_group == nullptr || m_group->updatedFrame == frame) // Not joined when added during the update phase
+        return;
+
+    m_group->updatedFrame = frame;
+    updateGroup(*m_group, engine.frameInfo().deltaTime);
+}
+
+auto Animator::step(const DurationType deltaTime) -> void
 {
     if (m_animationChanged)
     {
         m_timeSinceAnimationStart = DurationType::zero();
         m_animationChanged = false;
-        std::fill(m_nodeTransforms.begin(), m_nodeTransforms.end(), AnimatedTransform{});
+
+        // Nodes of the previous animation go back to their rest pose
+        m_changedNodes = m_pose.animated;
+        m_pose = m_mesh.restPose();
+        m_channelCursors.clear();
+
+        if (m_currentAnimationIndex >= 0)
+        {
+            const auto& channels = m_mesh.animations()[m_currentAnimationIndex].channels();
+            m_channelCursors.resize(channels.size(), 0);
+            for (const auto& channel : channels)
+                m_pose.setAnimated(channel.node);
+        }
+
+        m_changedNodes |= m_pose.animated;
+        ++m_poseVersion;
     }
     else
     {
-        m_timeSinceAnimationStart += engine.frameInfo().deltaTime;
+        m_timeSinceAnimationStart += deltaTime;
+
+        if (m_currentAnimationIndex >= 0)
+        {
+            m_changedNodes = m_pose.animated;
+            ++m_poseVersion;
+        }
     }
+}
 
-    if (m_currentAnimationIndex < 0)
-        return;
+auto Animator::updateGroup(Group& group, const DurationType deltaTime) -> void
+{
+    auto& playing = group.playing;
+
+    playing.clear();
+    for (auto* animator : group.animators)
+    {
+        animator->step(deltaTime);
+        if (animator->m_currentAnimationIndex >= 0)
+            playing.push_back(animator);
+    }
+
+    std::ranges::sort(playing, {}, &Animator::m_currentAnimationIndex);
+
+    for (auto begin = playing.begin(); begin != playing.end();)
+    {
+        const int animationIndex = (*begin)->m_currentAnimationIndex;
+        const auto end = std::find_if(begin, playing.end(), [animationIndex](const Animator* animator)
+        {
+            return animator->m_currentAnimationIndex != animationIndex;
+        });
 
-    const tinygltf::Animation& gltfAnimation = m_mesh.model().animations[m_currentAnimationIndex];
-    const Animation& animation = m_mesh.animations()[m_currentAnimationIndex];
+        const auto& mesh = (*begin)->m_mesh;
+        evaluateBatch(group, std::span(begin, end), mesh.animations()[animationIndex]);
+        begin = end;
+    }
+}
+
+auto Animator::evaluateBatch(Group& group, const std::span<Animator* const> animators,
+                             const Animation& animation) -> void
+{
+    const size_t count = animators.size();
 
-    const float animationTime = fmodf(m_timeSinceAnimationStart.count(), animation.duration());
+    group.times.resize(count);
+    group.cursors.resize(count);
+    group.vec3s.resize(count);
+    group.quats.resize(count);
 
-    for (const auto& channel : gltfAnimation.channels)
+    for (size_t i = 0; i < count; ++i)
+        group.times[i] = fmodf(animators[i]->m_timeSinceAnimationStart.count(), animation.duration());
+
+    const auto& channels = animation.channels();
+    for (size_t c = 0; c < channels.size(); ++c)
     {
-        auto& nodeTransform = m_nodeTransforms[channel.target_node];
-
-        if (channel.target_path == "rotation")
-            nodeTransform.rotation = animation.sampler(channel.sampler).quat(animationTime);
-        else if (channel.target_path == "scale")
-            nodeTransform.scale = animation.sampler(channel.sampler).vec3(animationTime);
-        else if (channel.target_path == "translation")
-            nodeTransform.translation = animation.sampler(channel.sampler).vec3(animationTime);
+        const auto& channel = channels[c];
+        const auto& sampler = animation.sampler(channel.sampler);
+
+        for (size_t i = 0; i < count; ++i)
+            group.cursors[i] = animators[i]->m_channelCursors[c];
+
+        switch (channel.path)
+        {
+        case AnimationPath::Translation:
+            sampler.vec3Batch(group.times, group.cursors, group.vec3s);
+            for (size_t i = 0; i < count; ++i)
+                animators[i]->m_pose.translations[channel.node] = group.vec3s[i];
+            break;
+        case AnimationPath::Rotation:
+            sampler.quatBatch(group.times, group.cursors, group.quats);
+            for (size_t i = 0; i < count; ++i)
+                animators[i]->m_pose.rotations[channel.node] = group.quats[i];
+            break;
+        case AnimationPath::Scale:
+            sampler.vec3Batch(group.times, group.cursors, group.vec3s);
+            for (size_t i = 0; i < count; ++i)
+                animators[i]->m_pose.scales[channel.node] = group.vec3s[i];
+            break;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+            animators[i]->m_channelCursors[c] = group.cursors[i];
     }
 }
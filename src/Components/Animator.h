@@ -6,35 +6,46 @@
 #define ANIMATOR_H
 
 #include "UserInterface.h"
+#include "Engine/AnimatorGroup.h"
 #include "Engine/FrameInfo.h"
 #include "Engine/Engine.h"
 #include "Engine/EngineComponent.h"
 #include "Engine/Mesh.h"
+#include <span>
 #include <utility>
 
 class Animator final : public EngineComponent
 {
-public:
-    struct AnimatedTransform
-    {
-        std::optional<glm::vec3> translation;
-        std::optional<glm::quat> rotation;
-        std::optional<glm::vec3> scale;
-    };
-
 private:
+    using Group = AnimatorGroup;
+
     bool m_animationChanged{false};
     int m_currentAnimationIndex{-1};
     DurationType m_timeSinceAnimationStart{DurationType::zero()};
 
     const Mesh& m_mesh;
 
-    std::vector<AnimatedTransform> m_nodeTransforms;
+    Pose m_pose;
+    uint64_t m_poseVersion{0};
+    DynamicBitset m_changedNodes;
+    std::vector<size_t> m_channelCursors;
+    Engine* m_engine{nullptr};
+    Group* m_group{nullptr}; // Joined on the first onWillUpdate, before any animator of the frame updates
+
+    auto step(DurationType deltaTime) -> void;
+
+    static auto updateGroup(Group& group, DurationType deltaTime) -> void;
+    static auto evaluateBatch(Group& group, std::span<Animator* const> animators, const Animation& animation) -> void;
 
 public:
     explicit
     Animator(Object& object, const Mesh& mesh);
+    Animator(const Animator&) = delete;
+    ~Animator() override;
+
+    auto operator=(const Animator&) -> Animator& = delete;
 
+    auto onWillUpdate(Engine& engine) -> void override;
     auto onUpdate(Engine& engine) -> void override;
 
     auto setAnimation(const int index) -> void
@@ -45,10 +56,11 @@ public:
         m_animationChanged = true;
     }
 
-    [[nodiscard]] auto nodeTransform(const int node) const -> const AnimatedTransform&
-    {
-        return m_nodeTransforms[node];
-    }
+    [[nodiscard]] auto pose() const -> const Pose& { return m_pose; }
+
+    // Incremented every time the pose is written, changedNodes() then holds the nodes written by that update
+    [[nodiscard]] auto poseVersion() const -> uint64_t { return m_poseVersion; }
+    [[nodiscard]] auto changedNodes() const -> const DynamicBitset& { return m_changedNodes; }
 
     [[nodiscard]] auto mesh() const -> const Mesh&
     {
@@ -5,136 +5,185 @@
 #include "MeshRenderer.h"
 #include "Engine/Engine.h"
 #include "Engine/Object.h"
-#include "glm/gtc/type_ptr.hpp"
 
-static void* bufferOffset(const size_t offset)
-{
-    return reinterpret_cast<void*>(offset);
-}
+static_assert(std::tuple_size_v<decltype(RenderStats::lodNodes)> == MaxLodLevels);
 
-auto MeshRenderer::renderMesh(Engine& engine, const int meshIndex, const glm::mat4& transform) -> void
+auto MeshRenderer::queueMesh(Engine& engine, const int meshIndex, const int lod, const glm::mat4& transform) const
+    -> void
 {
-    const auto& mesh = m_mesh.model().meshes[meshIndex];
     const auto& meshRenderInfo = m_mesh.renderInfo().meshes[meshIndex];
-
-    for (int p = 0; p < mesh.primitives.size(); ++p)
+    const auto primitiveCount = static_cast<int>(m_mesh.model().meshes[meshIndex].primitives.size());
+    for (int p = 0; p < primitiveCount; ++p)
     {
-        const auto& primitive = mesh.primitives[p];
         const auto& primitiveRenderInfo = meshRenderInfo.primitives[p];
+        const bool multiDraw = primitiveRenderInfo.mergedGroup >= 0;
+        const auto extraFlags = (m_instanced || multiDraw) ? ShaderHasInstanceTransforms : ShaderHasNone;
+
+        auto& program = m_program.get().getProgram(primitiveRenderInfo.shaderFlags | extraFlags);
+        engine.renderQueue().push(m_mesh, meshIndex, p, lod, program, m_polygonMode,
+                                  multiDraw ? RenderQueue::DrawMode::MultiDraw
+                                            : m_instanced ? RenderQueue::DrawMode::Instanced
+                                                          : RenderQueue::DrawMode::Single,
+                                  transform);
+    }
+}
 
-        auto& program = m_program.get().getProgram(primitiveRenderInfo.shaderFlags);
-        engine.useProgram(program);
-
-        auto& vertexArray = engine.getVertexArray(primitiveRenderInfo.vertexArrayFlags);
-        engine.bindVertexArray(vertexArray);
-
-        for (const auto& [attribute, accessorIndex] : primitive.attributes)
-        {
-            const auto& accessor = m_mesh.model().accessors[accessorIndex];
-            const auto& accessorRenderInfo = m_mesh.renderInfo().accessors[accessorIndex];
-
-            const int attributeLocation = VertexArray::getAttributeLocation(attribute);
-            if (attributeLocation != -1)
-            {
-                vertexArray.bindArrayBuffer(accessorRenderInfo.bufferId);
-                glVertexAttribPointer(attributeLocation,
-                                      accessorRenderInfo.componentCount,
-                                      accessor.componentType,
-                                      GL_FALSE,
-                                      accessorRenderInfo.byteStride,
-                                      bufferOffset(accessor.byteOffset));
-            }
-        }
-
-        program.setMat4("u_transform", transform);
-
-        if (primitive.material >= 0)
-        {
-            const auto& material = m_mesh.model().materials[primitive.material];
-
-            engine.setDoubleSided(material.doubleSided);
-
-            if (material.pbrMetallicRoughness.baseColorTexture.index >= 0)
-            {
-                engine.bindTexture(0, m_mesh.texture(material.pbrMetallicRoughness.baseColorTexture.index));
-                program.setInt("u_baseColorTexture", 0);
-                program.setVec4("u_baseColorFactor",
-                                glm::make_vec4(material.pbrMetallicRoughness.baseColorFactor.data()));
-            }
-
-            if (material.normalTexture.index >= 0)
-            {
-                engine.bindTexture(1, m_mesh.texture(material.normalTexture.index));
-                program.setInt("u_normalMap", 1);
-                program.setFloat("u_normalScale", static_cast<float>(material.normalTexture.scale));
-            }
-        }
-        else
-        {
-            engine.setDoubleSided(false);
-        }
+auto MeshRenderer::selectLod(const size_t nodeIndex, const float screenSize) -> int
+{
+    const auto& thresholds = m_lodSettings.thresholds;
+    const float hysteresis = m_lodSettings.hysteresis;
+
+    // A threshold must be passed by the hysteresis margin, so a node standing on it keeps its level
+    int lod = m_nodeLods[nodeIndex];
+    while (lod + 1 < static_cast<int>(MaxLodLevels) && screenSize < thresholds[lod] * (1.0f - hysteresis))
+        ++lod;
+    while (lod > 0 && screenSize > thresholds[lod - 1] * (1.0f + hysteresis))
+        --lod;
+
+    m_nodeLods[nodeIndex] = static_cast<uint8_t>(lod);
+    return lod;
+}
 
-        assert(primitive.indices >= 0); // TODO handle non indexed primitives
+auto MeshRenderer::setInstanced(const bool instanced) -> void
+{
+    if (instanced)
+    {
+        auto e_prepareResult = m_mesh.prepareShaderPrograms(m_program, ShaderHasInstanceTransforms);
+        if (!e_prepareResult)
+            throw std::runtime_error("Failed to prepare shader programs: " + e_prepareResult.error());
+    }
 
-        const tinygltf::Accessor& indexAccessor = m_mesh.model().accessors[primitive.indices];
+    m_instanced = instanced;
+}
 
-        const GLuint bufferId = m_mesh.buffer(indexAccessor.bufferView);
-        vertexArray.bindElementArrayBuffer(bufferId);
+auto MeshRenderer::trackChanges() -> void
+{
+    const Transform& transform = object().transform();
+    if (transform != m_lastTransform)
+    {
+        m_lastTransform = transform;
+        m_objectMatrix = transform.trs();
+        m_allNodesDirty = true;
+    }
 
-        glDrawElements(primitive.mode, static_cast<GLsizei>(indexAccessor.count), indexAccessor.componentType,
-                       bufferOffset(indexAccessor.byteOffset));
-        // CheckErrors("draw elements");
+    if (m_animator.has_value())
+    {
+        const auto& animator = m_animator->get();
+        if (animator.poseVersion() == m_lastPoseVersion + 1)
+            m_dirtyNodes |= animator.changedNodes();
+        else if (animator.poseVersion() != m_lastPoseVersion)
+            m_allNodesDirty = true; // Missed some updates, so changedNodes() is not enough
+        m_lastPoseVersion = animator.poseVersion();
     }
 }
 
-auto MeshRenderer::renderNode(Engine& engine, const int nodeIndex, glm::mat4 transform) -> void
+auto MeshRenderer::updateWorldMatrices(const Pose& pose) -> void
 {
-    const tinygltf::Node& node = m_mesh.model().nodes[nodeIndex];
+    const auto& flatNodes = m_mesh.flatNodes();
 
-    // TODO Precalculate matrix or trs
-    if (!node.matrix.empty())
+    for (size_t i = 0; i < flatNodes.size(); ++i)
     {
-        transform *= glm::mat4(node.matrix[0], node.matrix[1], node.matrix[2], node.matrix[3],
-                               node.matrix[4], node.matrix[5], node.matrix[6], node.matrix[7],
-                               node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11],
-                               node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]);
+        const auto& flatNode = flatNodes[i];
+        const bool parentUpdated = flatNode.parent >= 0 && m_updatedNodes[flatNode.parent];
+        const bool dirty = m_allNodesDirty || parentUpdated || m_dirtyNodes.test(flatNode.node);
+
+        m_updatedNodes[i] = dirty;
+        if (!dirty)
+            continue;
+
+        const glm::mat4& parentMatrix = flatNode.parent < 0 ? m_objectMatrix : m_worldMatrices[flatNode.parent];
+
+        // The scale multiplier is applied after the node scale, both are diagonal so they can be merged
+        m_worldMatrices[i] = parentMatrix * pose.localMatrix(flatNode.node,
+                                                             pose.scales[flatNode.node] *
+                                                             m_scaleMultiplier[flatNode.node]);
+        if (flatNode.mesh > -1)
+            m_worldBounds[i] = m_mesh.meshBounds()[flatNode.mesh].transformed(m_worldMatrices[i]);
     }
-    else
+
+    m_allNodesDirty = false;
+    m_dirtyNodes.reset();
+}
+
+auto MeshRenderer::onUpdateBounds(Engine& engine, AABB& bounds) -> bool
+{
+    if (!displayed())
+        return true;
+
+    trackChanges();
+    if (m_allNodesDirty || m_dirtyNodes.any())
     {
-        const auto& tr = m_animator.has_value()
-                             ? m_animator->get().nodeTransform(nodeIndex)
-                             : Animator::AnimatedTransform{};
-
-        if (tr.translation.has_value())
-            transform = glm::translate(transform, *tr.translation);
-        else if (!node.translation.empty())
-            transform = glm::translate(
-                transform, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
-
-        if (tr.rotation.has_value())
-            transform *= glm::mat4_cast(*tr.rotation);
-        else if (!node.rotation.empty())
-            transform *= glm::mat4_cast(glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]));
-
-        if (tr.scale.has_value())
-            transform = glm::scale(transform, *tr.scale);
-        else if (!node.scale.empty())
-            transform = glm::scale(transform, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
-    }
+        updateWorldMatrices(m_animator.has_value() ? m_animator->get().pose() : m_mesh.restPose());
 
-    transform = glm::scale(transform, m_scaleMultiplier[nodeIndex]);
+        // Only rebuilt when a node moved, a static renderer returns the cached union
+        m_objectBounds = {};
+        m_objectBounded = true;
+        const auto& flatNodes = m_mesh.flatNodes();
+        for (size_t i = 0; i < flatNodes.size(); ++i)
+        {
+            if (flatNodes[i].mesh < 0)
+                continue;
+            m_objectBounded &= !m_worldBounds[i].empty();
+            m_objectBounds.expand(m_worldBounds[i]);
+        }
+    }
 
-    if (node.mesh > -1)
-        renderMesh(engine, node.mesh, transform);
-    for (const auto childIndex : node.children)
-        renderNode(engine, childIndex, transform);
+    bounds.expand(m_objectBounds);
+    return m_objectBounded;
 }
 
 void MeshRenderer::onRender(Engine& engine)
 {
     if (!displayed())
         return;
-    setPolygoneMode(engine, m_polygonMode);
-    for (const auto nodeIndex : m_mesh.model().scenes[m_mesh.model().defaultScene].nodes)
-        renderNode(engine, nodeIndex, object().transform().trs());
+
+    const auto& frustum = engine.frustum();
+    auto& stats = engine.renderStats();
+
+    std::optional<std::reference_wrapper<OcclusionCuller>> occlusionCuller;
+    if (m_occlusionCulled)
+        occlusionCuller = engine.occlusionCuller();
+    if (occlusionCuller && m_occlusionQueries.empty())
+    {
+        m_occlusionQueries.resize(m_mesh.flatNodes().size(), -1);
+        for (size_t i = 0; i < m_mesh.flatNodes().size(); ++i)
+        {
+            if (m_mesh.flatNodes()[i].mesh >= 0)
+                m_occlusionQueries[i] = occlusionCuller->get().createQuery();
+        }
+    }
+    const glm::vec3 cameraPosition(engine.frameUniforms().cameraPosition);
+    const float projectionScale = engine.frameUniforms().projection[1][1]; // 1 / tan(fov / 2)
+
+    const auto& flatNodes = m_mesh.flatNodes();
+    for (size_t i = 0; i < flatNodes.size(); ++i)
+    {
+        if (flatNodes[i].mesh < 0)
+            continue;
+
+        if (!frustum.intersects(m_worldBounds[i]))
+        {
+            ++stats.culledNodes;
+            continue;
+        }
+
+        if (occlusionCuller && !occlusionCuller->get().isVisible(m_occlusionQueries[i], m_worldBounds[i],
+                                                                 cameraPosition))
+        {
+            ++stats.occludedNodes;
+            continue;
+        }
+
+        const auto& bounds = m_worldBounds[i];
+        const float radius = glm::length(bounds.extent());
+        const float distance = glm::length(bounds.center() - cameraPosition);
+        const float screenSize = bounds.empty() || distance <= radius
+                                     ? std::numeric_limits<float>::max()
+                                     : radius * projectionScale / distance;
+        const int lod = selectLod(i, screenSize);
+
+        ++stats.visibleNodes;
+        ++stats.lodNodes[lod];
+        queueMesh(engine, flatNodes[i].mesh, lod, m_worldMatrices[i]);
+    }
 }
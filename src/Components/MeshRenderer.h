@@ -7,42 +7,93 @@
 #include "Animator.h"
 #include "Engine/EngineComponent.h"
 #include "Engine/Mesh.h"
+#include "Engine/OcclusionCuller.h"
+#include "Engine/Transform.h"
 #include "OpenGL/ShaderProgram.h"
 
+/**
+ * Screen sizes are the part of the screen height covered by the bounding sphere of a node
+ */
+struct LodSettings
+{
+    std::array<float, MaxLodLevels - 1> thresholds{0.25f, 0.12f, 0.06f}; // Level i + 1 is used below thresholds[i]
+    float hysteresis{0.15f}; // Relative margin around a threshold crossed before switching level
+};
+
 class MeshRenderer final : public EngineComponent
 {
 private:
     const Mesh& m_mesh;
     bool m_displayed{true};
     GLenum m_polygonMode{GL_FILL};
+    bool m_instanced{false};
+    bool m_occlusionCulled{false};
+    std::vector<OcclusionCuller::QueryId> m_occlusionQueries; // Indexed like Mesh::flatNodes, created on first use
     std::optional<std::reference_wrapper<const Animator>> m_animator;
     std::vector<glm::vec3> m_scaleMultiplier;
+    std::vector<glm::mat4> m_worldMatrices; // Indexed like Mesh::flatNodes
+    std::vector<AABB> m_worldBounds; // Indexed like Mesh::flatNodes, empty for nodes without mesh
+    AABB m_objectBounds; // Union of m_worldBounds, updated with them
+    bool m_objectBounded{true}; // False when a node bounds is empty
+    std::vector<uint8_t> m_nodeLods; // Indexed like Mesh::flatNodes, level selected during the last render
+    LodSettings m_lodSettings;
+
+    // World matrices are only recomputed for the subtrees of the nodes changed since the last render
+    Transform m_lastTransform;
+    glm::mat4 m_objectMatrix{1.0f};
+    uint64_t m_lastPoseVersion{0};
+    bool m_allNodesDirty{true};
+    DynamicBitset m_dirtyNodes; // Indexed by glTF node
+    std::vector<uint8_t> m_updatedNodes; // Indexed like Mesh::flatNodes
 
     std::reference_wrapper<ShaderProgram>& m_program; // TODO Change
 
-    auto renderMesh(Engine& engine, int meshIndex, const glm::mat4& transform) -> void;
-    auto renderNode(Engine& engine, int nodeIndex, glm::mat4 transform) -> void;
+    auto queueMesh(Engine& engine, int meshIndex, int lod, const glm::mat4& transform) const -> void;
+    auto selectLod(size_t nodeIndex, float screenSize) -> int;
+    auto trackChanges() -> void;
+    auto updateWorldMatrices(const Pose& pose) -> void;
 
 public:
     explicit MeshRenderer(Object& object, const Mesh& model, std::reference_wrapper<ShaderProgram>& program) :
         EngineComponent(object), m_mesh(model), m_program(program)
     {
         m_scaleMultiplier.resize(m_mesh.model().nodes.size(), glm::vec3(1));
+        m_worldMatrices.resize(m_mesh.flatNodes().size());
+        m_worldBounds.resize(m_mesh.flatNodes().size());
+        m_nodeLods.resize(m_mesh.flatNodes().size(), 0);
+        m_dirtyNodes.resize(m_mesh.model().nodes.size());
+        m_updatedNodes.resize(m_mesh.flatNodes().size(), 0);
 
         // maybe make Create static function
-        auto e_prepareResult = m_mesh.prepareShaderPrograms(program);
+        // Merged primitives are multi drawn, reading their transforms like instances
+        const auto extraFlags = m_mesh.merged() ? ShaderHasInstanceTransforms : ShaderHasNone;
+        auto e_prepareResult = m_mesh.prepareShaderPrograms(program, extraFlags);
         if (!e_prepareResult)
             throw std::runtime_error("Failed to prepare shader programs: " + e_prepareResult.error());
     }
 
     [[nodiscard]] auto mesh() const -> const Mesh& { return m_mesh; }
 
-    auto setAnimator(const Animator& animator) -> void { m_animator = animator; }
-    auto unsetAnimator() -> void { m_animator = std::nullopt; }
+    auto setAnimator(const Animator& animator) -> void
+    {
+        m_animator = animator;
+        m_lastPoseVersion = animator.poseVersion();
+        m_allNodesDirty = true;
+    }
+
+    auto unsetAnimator() -> void
+    {
+        m_animator = std::nullopt;
+        m_allNodesDirty = true;
+    }
 
     auto setScaleMultiplier(const size_t nodeIndex, const glm::vec3 scale) -> void
     {
-        m_scaleMultiplier[nodeIndex] = scale;
+        if (m_scaleMultiplier[nodeIndex] != scale)
+        {
+            m_scaleMultiplier[nodeIndex] = scale;
+            m_dirtyNodes.set(nodeIndex);
+        }
     }
 
     [[nodiscard]] auto getScaleMultiplier(const size_t nodeIndex) const -> glm::vec3
@@ -60,6 +111,26 @@ public:
         m_displayed = display;
     }
 
+    [[nodiscard]] auto instanced() const noexcept -> bool { return m_instanced; }
+
+    /**
+     * When instanced, the primitives queued in the engine RenderQueue are drawn together with the same primitives of
+     * every other instanced renderer
+     */
+    auto setInstanced(bool instanced) -> void;
+
+    [[nodiscard]] auto lodSettings() const noexcept -> const LodSettings& { return m_lodSettings; }
+
+    auto setLodSettings(const LodSettings& lodSettings) -> void { m_lodSettings = lodSettings; }
+
+    [[nodiscard]] auto occlusionCulled() const noexcept -> bool { return m_occlusionCulled; }
+
+    /**
+     * Skip the nodes hidden by the rest of the scene when the engine occlusion culling is initialized, worth it for
+     * large meshes made of many nodes occluding each other
+     */
+    auto setOcclusionCulled(const bool occlusionCulled) -> void { m_occlusionCulled = occlusionCulled; }
+
     [[nodiscard]] auto polygonMode() const noexcept -> GLenum { return m_polygonMode; }
 
     auto setPolygoneMode(Engine &engine, const GLenum polygonMode) -> void
@@ -69,6 +140,7 @@ public:
             engine.setPolygoneMode(polygonMode);
     }
 
+    auto onUpdateBounds(Engine& engine, AABB& bounds) -> bool override;
     auto onRender(Engine& engine) -> void override;
 };
 
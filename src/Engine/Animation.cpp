@@ -4,14 +4,14 @@
 
 #include "Animation.h"
 
-auto Animation::initInputBuffer(const tinygltf::Model& model, const int accessorIndex)
+auto Animation::initInputBuffer(const tinygltf::Model& model, const ModelBuffers& buffers, const int accessorIndex)
     -> AnimationSampler::InputBuffer
 {
     const auto& accessor = model.accessors[accessorIndex];
     assert(accessor.type == TINYGLTF_TYPE_SCALAR);
     assert(accessor.componentType == GL_FLOAT);
     const auto& bufferView = model.bufferViews[accessor.bufferView];
-    const auto& buffer = model.buffers[bufferView.buffer];
+    const auto buffer = buffers[bufferView.buffer];
 
     const size_t offset = bufferView.byteOffset + accessor.byteOffset;
     constexpr size_t attributeSize = sizeof(GLfloat); // accessor.componentType MUST be GL_FLOAT
@@ -22,7 +22,7 @@ auto Animation::initInputBuffer(const tinygltf::Model& model, const int accessor
     assert(length > 0);
     assert(accessor.byteOffset + length <= bufferView.byteLength);
 
-    const auto data = reinterpret_cast<const GLfloat*>(buffer.data.data() + offset);
+    const auto data = reinterpret_cast<const GLfloat*>(buffer.data() + offset);
     return {
         .size = accessor.count,
         .attributeStride = byteStride / sizeof(GLfloat),
@@ -30,12 +30,12 @@ auto Animation::initInputBuffer(const tinygltf::Model& model, const int accessor
     };
 }
 
-auto Animation::initOutputBuffer(const tinygltf::Model& model, const int accessorIndex)
+auto Animation::initOutputBuffer(const tinygltf::Model& model, const ModelBuffers& buffers, const int accessorIndex)
     -> AnimationSampler::OutputBuffer
 {
     const auto& accessor = model.accessors[accessorIndex];
     const auto& bufferView = model.bufferViews[accessor.bufferView];
-    const auto& buffer = model.buffers[bufferView.buffer];
+    const auto buffer = buffers[bufferView.buffer];
 
     const size_t offset = bufferView.byteOffset + accessor.byteOffset;
     const size_t attributeSize =
@@ -46,7 +46,7 @@ auto Animation::initOutputBuffer(const tinygltf::Model& model, const int accesso
     assert(length > 0);
     assert(accessor.byteOffset + length <= bufferView.byteLength);
 
-    const GLubyte* bytes = buffer.data.data() + offset;
+    const GLubyte* bytes = buffer.data() + offset;
     return {
         .size = length,
         .byteStride = byteStride,
@@ -54,17 +54,48 @@ auto Animation::initOutputBuffer(const tinygltf::Model& model, const int accesso
     };
 }
 
-auto Animation::Create(const tinygltf::Model& model, const tinygltf::Animation& animation) -> Animation
+auto Animation::initChannels(const tinygltf::Animation& animation) -> std::vector<AnimationChannel>
+{
+    std::vector<AnimationChannel> channels;
+
+    channels.reserve(animation.channels.size());
+    for (const auto& channel : animation.channels)
+    {
+        if (channel.target_node < 0)
+            continue;
+
+        AnimationPath path;
+        if (channel.target_path == "translation")
+            path = AnimationPath::Translation;
+        else if (channel.target_path == "rotation")
+            path = AnimationPath::Rotation;
+        else if (channel.target_path == "scale")
+            path = AnimationPath::Scale;
+        else
+            continue; // Morph target weights are not supported
+
+        channels.push_back({
+            .node = channel.target_node,
+            .path = path,
+            .sampler = static_cast<uint32_t>(channel.sampler),
+        });
+    }
+
+    return channels;
+}
+
+auto Animation::Create(const tinygltf::Model& model, const ModelBuffers& buffers,
+                       const tinygltf::Animation& animation) -> Animation
 {
     float duration = 0;
     std::vector<AnimationSampler> samplers;
-    const auto samplerCount = model.samplers.size();
+    const auto samplerCount = animation.samplers.size();
 
     samplers.reserve(samplerCount);
     for (const auto& i : animation.samplers)
     {
-        auto input = initInputBuffer(model, i.input);
-        auto output = initOutputBuffer(model, i.output);
+        auto input = initInputBuffer(model, buffers, i.input);
+        auto output = initOutputBuffer(model, buffers, i.output);
 
         const auto& inserted = samplers.emplace_back(input, output);
         duration = std::max(duration, inserted.duration());
@@ -74,5 +105,6 @@ auto Animation::Create(const tinygltf::Model& model, const tinygltf::Animation&
         duration,
         samplerCount,
         std::move(samplers),
+        initChannels(animation),
     };
 }
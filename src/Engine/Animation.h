@@ -7,6 +7,25 @@
 #include <vector>
 
 #include "AnimationSampler.h"
+#include "ModelBuffers.h"
+
+enum class AnimationPath : unsigned char
+{
+    Translation,
+    Rotation,
+    Scale,
+};
+
+/**
+ * A glTF animation channel resolved at load time, so playback never touches the tinygltf model.
+ * The sampler output type follows from the path: vec3 for translation and scale, quat for rotation.
+ */
+struct AnimationChannel
+{
+    int node;
+    AnimationPath path;
+    uint32_t sampler;
+};
 
 class Animation
 {
@@ -14,26 +33,35 @@ private:
     float m_duration;
     size_t m_samplerCount;
     std::vector<AnimationSampler> m_samplers;
+    std::vector<AnimationChannel> m_channels;
 
-    static auto initInputBuffer(const tinygltf::Model& model, int accessorIndex) -> AnimationSampler::InputBuffer;
-    static auto initOutputBuffer(const tinygltf::Model& model, int accessorIndex) -> AnimationSampler::OutputBuffer;
+    static auto initInputBuffer(const tinygltf::Model& model, const ModelBuffers& buffers,
+                                int accessorIndex) -> AnimationSampler::InputBuffer;
+    static auto initOutputBuffer(const tinygltf::Model& model, const ModelBuffers& buffers,
+                                 int accessorIndex) -> AnimationSampler::OutputBuffer;
+    static auto initChannels(const tinygltf::Animation& animation) -> std::vector<AnimationChannel>;
 
 public:
     Animation(const float duration,
               const size_t samplerCount,
-              std::vector<AnimationSampler>&& samplers)
+              std::vector<AnimationSampler>&& samplers,
+              std::vector<AnimationChannel>&& channels)
         : m_duration(duration),
           m_samplerCount(samplerCount),
-          m_samplers(samplers)
+          m_samplers(std::move(samplers)),
+          m_channels(std::move(channels))
     {
     }
 
-    static auto Create(const tinygltf::Model& model, const tinygltf::Animation& animation) -> Animation;
+    static auto Create(const tinygltf::Model& model, const ModelBuffers& buffers,
+                       const tinygltf::Animation& animation) -> Animation;
 
     [[nodiscard]] auto duration() const -> float { return m_duration; }
 
     [[nodiscard]] auto sampler(const size_t index) const -> const AnimationSampler& { return m_samplers[index]; }
     [[nodiscard]] auto samplersCount() const -> size_t { return m_samplerCount; }
+
+    [[nodiscard]] auto channels() const -> const std::vector<AnimationChannel>& { return m_channels; }
 };
 
 #endif //ANIMATION_H
@@ -5,33 +5,186 @@
 #include "AnimationSampler.h"
 
 #include <algorithm>
+#include <limits>
 
+#include "Utility/BatchInterpolation.h"
 #include "Utility/StridedIterator.h"
 
 using difference_type = StridedIterator<float*>::difference_type;
 
-auto AnimationSampler::getInput(const float time) const -> InputResult
+auto AnimationSampler::upperBoundIndex(const float time) const -> size_t
 {
     const auto begin = StridedIterator(m_input.data, static_cast<difference_type>(m_input.attributeStride));
     const auto end = begin + static_cast<difference_type>(m_input.size);
-    const auto upperBound = std::upper_bound(begin, end, time);
+    return static_cast<size_t>(std::upper_bound(begin, end, time) - begin);
+}
+
+auto AnimationSampler::makeInput(const size_t prevIndex, const float time) const -> InputResult
+{
+    const size_t nextIndex = prevIndex + 1;
+    const auto prevVal = inputAt(prevIndex);
+    const auto nextVal = inputAt(nextIndex);
+
+    const float stepRatio = (nextVal != prevVal) ? ((time - prevVal) / (nextVal - prevVal)) : 0;
+    return {prevIndex, nextIndex, stepRatio};
+}
+
+auto AnimationSampler::getInput(const float time) const -> InputResult
+{
+    const auto upperBound = upperBoundIndex(time);
 
     // Clamp to first and last
-    if (upperBound == begin)
+    if (upperBound == 0)
         return {0, 0, 0};
-    if (upperBound == end)
+    if (upperBound == m_input.size)
         return {m_input.size - 1, m_input.size - 1, 1};
 
-    const auto next = upperBound;
-    const auto prev = upperBound - 1;
+    return makeInput(upperBound - 1, time);
+}
 
-    const auto prevVal = *prev;
-    const auto nextVal = *next;
-    const auto prevIndex = prev - begin;
-    const auto nextIndex = next - begin;
+auto AnimationSampler::getInput(const float time, size_t& cursor) const -> InputResult
+{
+    const size_t last = m_input.size - 1;
 
-    const float stepRatio = (nextVal != prevVal) ? ((time - prevVal) / (nextVal - prevVal)) : 0;
-    return {static_cast<size_t>(prevIndex), static_cast<size_t>(nextIndex), stepRatio};
+    // Clamp to first and last
+    if (time < inputAt(0))
+    {
+        cursor = 0;
+        return {0, 0, 0};
+    }
+    if (time >= inputAt(last))
+    {
+        cursor = last;
+        return {last, last, 1};
+    }
+
+    // From here inputAt(0) <= time < inputAt(last), find prev so that inputAt(prev) <= time < inputAt(prev + 1)
+    size_t prev = std::min(cursor, last - 1);
+    size_t steps = 0;
+    if (inputAt(prev) <= time)
+    {
+        while (steps < MaxCursorScan && inputAt(prev + 1) <= time)
+        {
+            ++prev;
+            ++steps;
+        }
+        if (inputAt(prev + 1) <= time)
+            prev = upperBoundIndex(time) - 1;
+    }
+    else
+    {
+        // Went backward, usually a loop wraparound or a seek
+        while (steps < MaxCursorScan && inputAt(prev) > time)
+        {
+            --prev;
+            ++steps;
+        }
+        if (inputAt(prev) > time)
+            prev = upperBoundIndex(time) - 1;
+    }
+
+    cursor = prev;
+    return makeInput(prev, time);
+}
+
+auto AnimationSampler::vec3Batch(const std::span<const float> times, const std::span<size_t> cursors,
+                                 const std::span<glm::vec3> out) const -> void
+{
+    assert(cursors.size() == times.size() && out.size() == times.size());
+
+    alignas(32) float prev[3][BatchBlockSize];
+    alignas(32) float next[3][BatchBlockSize];
+    alignas(32) float t[BatchBlockSize];
+    alignas(32) float result[3][BatchBlockSize];
+
+    for (size_t begin = 0; begin < times.size(); begin += BatchBlockSize)
+    {
+        const size_t count = std::min(BatchBlockSize, times.size() - begin);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto input = getInput(times[begin + i], cursors[begin + i]);
+            const auto prevValue = getOutputPtr<float>(input.prevIndex);
+            const auto nextValue = getOutputPtr<float>(input.nextIndex);
+            for (int c = 0; c < 3; ++c)
+            {
+                prev[c][i] = prevValue[c];
+                next[c][i] = nextValue[c];
+            }
+            t[i] = input.t;
+        }
+
+        for (int c = 0; c < 3; ++c)
+            lerpBatch(prev[c], next[c], t, result[c], count);
+
+        for (size_t i = 0; i < count; ++i)
+            out[begin + i] = glm::vec3(result[0][i], result[1][i], result[2][i]);
+    }
+}
+
+auto AnimationSampler::quatBatch(const std::span<const float> times, const std::span<size_t> cursors,
+                                 const std::span<glm::quat> out, const QuatBlend blend) const -> void
+{
+    assert(cursors.size() == times.size() && out.size() == times.size());
+
+    // Components are stored x, y, z, w like in the glTF buffer
+    alignas(32) float prev[4][BatchBlockSize];
+    alignas(32) float next[4][BatchBlockSize];
+    alignas(32) float t[BatchBlockSize];
+    alignas(32) float dot[BatchBlockSize];
+    alignas(32) float prevWeight[BatchBlockSize];
+    alignas(32) float nextWeight[BatchBlockSize];
+    alignas(32) float result[4][BatchBlockSize];
+
+    const float* const prevComponents[4] = {prev[0], prev[1], prev[2], prev[3]};
+    const float* const nextComponents[4] = {next[0], next[1], next[2], next[3]};
+    float* const resultComponents[4] = {result[0], result[1], result[2], result[3]};
+
+    for (size_t begin = 0; begin < times.size(); begin += BatchBlockSize)
+    {
+        const size_t count = std::min(BatchBlockSize, times.size() - begin);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto input = getInput(times[begin + i], cursors[begin + i]);
+            const auto prevValue = getOutputPtr<float>(input.prevIndex);
+            const auto nextValue = getOutputPtr<float>(input.nextIndex);
+            for (int c = 0; c < 4; ++c)
+            {
+                prev[c][i] = prevValue[c];
+                next[c][i] = nextValue[c];
+            }
+            t[i] = input.t;
+        }
+
+        quatDotBatch(prevComponents, nextComponents, dot, count);
+
+        // Same weights as glm::slerp: take the shortest path, and fall back to a linear mix for close rotations
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float sign = dot[i] < 0 ? -1.0f : 1.0f;
+            const float cosTheta = dot[i] * sign;
+
+            if (blend == QuatBlend::Slerp && cosTheta <= 1.0f - std::numeric_limits<float>::epsilon())
+            {
+                const float angle = std::acos(cosTheta);
+                const float sinAngle = std::sin(angle);
+                prevWeight[i] = std::sin((1.0f - t[i]) * angle) / sinAngle;
+                nextWeight[i] = sign * std::sin(t[i] * angle) / sinAngle;
+            }
+            else
+            {
+                prevWeight[i] = 1.0f - t[i];
+                nextWeight[i] = sign * t[i];
+            }
+        }
+
+        quatBlendBatch(prevComponents, nextComponents, prevWeight, nextWeight, resultComponents, count,
+                       blend == QuatBlend::Nlerp);
+
+        for (size_t i = 0; i < count; ++i)
+            out[begin + i] = glm::quat(result[3][i], result[0][i], result[1][i], result[2][i]);
+    }
 }
 
 AnimationSampler::AnimationSampler(const InputBuffer& input, const OutputBuffer& output)
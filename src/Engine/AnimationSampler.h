@@ -5,10 +5,19 @@
 #ifndef ANIMATIONSAMPLER_H
 #define ANIMATIONSAMPLER_H
 
-#include "Engine.h"
+#include <cassert>
+#include <span>
+
+#include "glad/gl.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 
+enum class QuatBlend : unsigned char
+{
+    Slerp,
+    Nlerp,
+};
+
 class AnimationSampler
 {
 public:
@@ -31,6 +40,16 @@ private:
     InputBuffer m_input;
     OutputBuffer m_output;
 
+    /**
+     * Number of keyframes walked from the cursor before falling back to a binary search
+     */
+    static constexpr size_t MaxCursorScan = 4;
+
+    /**
+     * Number of instances gathered on the stack at once by the batch functions
+     */
+    static constexpr size_t BatchBlockSize = 64;
+
     struct InputResult
     {
         size_t prevIndex;
@@ -38,7 +57,16 @@ private:
         float t;
     };
 
+    [[nodiscard]] auto inputAt(const size_t index) const -> GLfloat
+    {
+        return m_input.data[index * m_input.attributeStride];
+    }
+
+    [[nodiscard]] auto upperBoundIndex(float time) const -> size_t;
+    [[nodiscard]] auto makeInput(size_t prevIndex, float time) const -> InputResult;
+
     [[nodiscard]] auto getInput(float time) const -> InputResult;
+    [[nodiscard]] auto getInput(float time, size_t& cursor) const -> InputResult;
 
     template<class T>
     [[nodiscard]] auto getOutputPtr(const size_t index) const -> const T*
@@ -46,36 +74,49 @@ private:
         return reinterpret_cast<const T*>(m_output.data + index * m_output.byteStride);
     }
 
-public:
-    AnimationSampler(const InputBuffer& input, const OutputBuffer& output);
-
-    [[nodiscard]] auto duration() const -> float { return m_duration; }
-
-    [[nodiscard]] auto vec3(const float time) const -> glm::vec3
+    [[nodiscard]] auto vec3(const InputResult& input) const -> glm::vec3
     {
-        const auto result = getInput(time);
-        return glm::mix(*getOutputPtr<glm::vec3>(result.prevIndex),
-                        *getOutputPtr<glm::vec3>(result.nextIndex),
-                        result.t);
+        return glm::mix(*getOutputPtr<glm::vec3>(input.prevIndex),
+                        *getOutputPtr<glm::vec3>(input.nextIndex),
+                        input.t);
     }
 
-    [[nodiscard]] auto vec4(const float time) const -> glm::vec4
+    [[nodiscard]] auto vec4(const InputResult& input) const -> glm::vec4
     {
-        const auto result = getInput(time);
-        return glm::mix(*getOutputPtr<glm::vec4>(result.prevIndex),
-                        *getOutputPtr<glm::vec4>(result.nextIndex),
-                        result.t);
+        return glm::mix(*getOutputPtr<glm::vec4>(input.prevIndex),
+                        *getOutputPtr<glm::vec4>(input.nextIndex),
+                        input.t);
     }
 
-    [[nodiscard]] auto quat(const float time) const -> glm::quat
+    [[nodiscard]] auto quat(const InputResult& input) const -> glm::quat
     {
-        const auto result = getInput(time);
-        const auto prev = getOutputPtr<float>(result.prevIndex);
-        const auto next = getOutputPtr<float>(result.nextIndex);
+        const auto prev = getOutputPtr<float>(input.prevIndex);
+        const auto next = getOutputPtr<float>(input.nextIndex);
         return glm::slerp(glm::quat(prev[3], prev[0], prev[1], prev[2]),
                           glm::quat(next[3], next[0], next[1], next[2]),
-                          result.t);
+                          input.t);
     }
+
+public:
+    AnimationSampler(const InputBuffer& input, const OutputBuffer& output);
+
+    [[nodiscard]] auto duration() const -> float { return m_duration; }
+
+    [[nodiscard]] auto vec3(const float time) const -> glm::vec3 { return vec3(getInput(time)); }
+    [[nodiscard]] auto vec4(const float time) const -> glm::vec4 { return vec4(getInput(time)); }
+    [[nodiscard]] auto quat(const float time) const -> glm::quat { return quat(getInput(time)); }
+
+    // Cursor variants: `cursor` is the keyframe found by the previous call on the same playback, so monotonic
+    // playback only walks a few keys instead of running a binary search. Start each playback with a cursor of 0.
+    [[nodiscard]] auto vec3(const float time, size_t& cursor) const -> glm::vec3 { return vec3(getInput(time, cursor)); }
+    [[nodiscard]] auto vec4(const float time, size_t& cursor) const -> glm::vec4 { return vec4(getInput(time, cursor)); }
+    [[nodiscard]] auto quat(const float time, size_t& cursor) const -> glm::quat { return quat(getInput(time, cursor)); }
+
+    // Batch variants: sample the same channel for many playbacks at once, one time and one cursor per playback.
+    // Slerp matches quat(), Nlerp is cheaper and fully vectorized.
+    auto vec3Batch(std::span<const float> times, std::span<size_t> cursors, std::span<glm::vec3> out) const -> void;
+    auto quatBatch(std::span<const float> times, std::span<size_t> cursors, std::span<glm::quat> out,
+                   QuatBlend blend = QuatBlend::Slerp) const -> void;
 };
 
 #endif //ANIMATIONSAMPLER_H
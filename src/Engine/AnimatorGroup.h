@@ -0,0 +1,33 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+#ifndef ANIMATORGROUP_H
+#define ANIMATORGROUP_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+class Animator;
+
+/**
+ * Animators of an engine sharing a mesh, evaluated together by the first of them updated in a frame, so each channel
+ * is sampled for every playback of an animation in one batch. Owned by the engine, see Engine::animatorGroup
+ */
+struct AnimatorGroup
+{
+    std::vector<Animator*> animators;
+    uint64_t updatedFrame{0};
+
+    // Scratch buffers, kept to avoid allocating every frame
+    std::vector<Animator*> playing;
+    std::vector<float> times;
+    std::vector<size_t> cursors;
+    std::vector<glm::vec3> vec3s;
+    std::vector<glm::quat> quats;
+};
+
+#endif //ANIMATORGROUP_H
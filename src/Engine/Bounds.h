@@ -0,0 +1,177 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+
+#include "glm/glm.hpp"
+
+/**
+ * Axis aligned bounding box, an empty box (min > max) is never culled since its extent is unknown
+ */
+struct AABB
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    auto operator==(const AABB& other) const -> bool = default;
+
+    [[nodiscard]] auto empty() const -> bool { return min.x > max.x; }
+
+    [[nodiscard]] auto center() const -> glm::vec3 { return (min + max) * 0.5f; }
+
+    [[nodiscard]] auto extent() const -> glm::vec3 { return (max - min) * 0.5f; }
+
+    [[nodiscard]] auto contains(const glm::vec3& point) const -> bool
+    {
+        return point.x >= min.x && point.y >= min.y && point.z >= min.z &&
+            point.x <= max.x && point.y <= max.y && point.z <= max.z;
+    }
+
+    [[nodiscard]] auto surfaceArea() const -> float
+    {
+        if (empty())
+            return 0.0f;
+        const glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    auto expand(const glm::vec3& point) -> void
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    auto expand(const AABB& other) -> void
+    {
+        if (other.empty())
+            return;
+        expand(other.min);
+        expand(other.max);
+    }
+
+    /**
+     * Smallest box containing this one transformed by matrix (Arvo's method)
+     */
+    [[nodiscard]] auto transformed(const glm::mat4& matrix) const -> AABB
+    {
+        if (empty())
+            return *this;
+
+        const glm::vec3 center = glm::vec3(matrix * glm::vec4(this->center(), 1.0f));
+        const glm::vec3 extent = this->extent();
+        const glm::vec3 newExtent = glm::abs(glm::vec3(matrix[0])) * extent.x +
+            glm::abs(glm::vec3(matrix[1])) * extent.y +
+            glm::abs(glm::vec3(matrix[2])) * extent.z;
+
+        return {.min = center - newExtent, .max = center + newExtent};
+    }
+};
+
+/**
+ * The six planes of a projection-view matrix, normals pointing inside
+ */
+struct Frustum
+{
+    enum Classification
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    std::array<glm::vec4, 6> planes{};
+
+    static auto FromMatrix(const glm::mat4& projectionView) -> Frustum
+    {
+        const glm::mat4 m = glm::transpose(projectionView);
+
+        Frustum frustum;
+        frustum.planes[0] = m[3] + m[0]; // Left
+        frustum.planes[1] = m[3] - m[0]; // Right
+        frustum.planes[2] = m[3] + m[1]; // Bottom
+        frustum.planes[3] = m[3] - m[1]; // Top
+        frustum.planes[4] = m[3] + m[2]; // Near
+        frustum.planes[5] = m[3] - m[2]; // Far
+        return frustum;
+    }
+
+    /**
+     * Conservative, a box crossing the frustum corners outside of it may be reported as intersecting
+     */
+    [[nodiscard]] auto intersects(const AABB& box) const -> bool
+    {
+        if (box.empty())
+            return true;
+
+        const glm::vec3 center = box.center();
+        const glm::vec3 extent = box.extent();
+        for (const auto& plane : planes)
+        {
+            const glm::vec3 normal = glm::vec3(plane);
+            const float radius = glm::dot(extent, glm::abs(normal));
+            if (glm::dot(normal, center) + plane.w + radius < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Same test as intersects, also telling when the box is fully inside so its content doesn't need to be tested
+     */
+    [[nodiscard]] auto classify(const AABB& box) const -> Classification
+    {
+        if (box.empty())
+            return Intersecting;
+
+        const glm::vec3 center = box.center();
+        const glm::vec3 extent = box.extent();
+        Classification result = Inside;
+        for (const auto& plane : planes)
+        {
+            const glm::vec3 normal = glm::vec3(plane);
+            const float radius = glm::dot(extent, glm::abs(normal));
+            const float distance = glm::dot(normal, center) + plane.w;
+            if (distance + radius < 0.0f)
+                return Outside;
+            if (distance - radius < 0.0f)
+                result = Intersecting;
+        }
+        return result;
+    }
+};
+
+struct Ray
+{
+    glm::vec3 origin{};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f};
+
+    /**
+     * Distance along the ray to the box entry point (0 when the origin is inside it), slab method
+     */
+    [[nodiscard]] auto intersects(const AABB& box, const float maxDistance) const -> std::optional<float>
+    {
+        if (box.empty())
+            return std::nullopt;
+
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+        const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+        const glm::vec3 tMin = glm::min(t0, t1);
+        const glm::vec3 tMax = glm::max(t0, t1);
+
+        const float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        const float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+        if (enter > exit)
+            return std::nullopt;
+        return enter;
+    }
+};
+
+#endif //BOUNDS_H
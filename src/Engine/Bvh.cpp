@@ -0,0 +1,256 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    constexpr uint32_t BinCount = 12;
+    constexpr uint32_t MaxSahDepth = 24; // Deeper nodes are split at the median, keeping the depth under the query stack size
+
+    struct Bin
+    {
+        AABB bounds;
+        uint32_t count{0};
+    };
+}
+
+auto Bvh::createProxy(const AABB& bounds, Object& object) -> ProxyId
+{
+    ProxyId proxy;
+    if (!m_freeProxies.empty())
+    {
+        proxy = m_freeProxies.back();
+        m_freeProxies.pop_back();
+        m_proxies[proxy] = {bounds, &object};
+    }
+    else
+    {
+        proxy = static_cast<ProxyId>(m_proxies.size());
+        m_proxies.push_back({bounds, &object});
+    }
+
+    m_needRebuild = true;
+    return proxy;
+}
+
+auto Bvh::destroyProxy(const ProxyId proxy) -> void
+{
+    assert(m_proxies[proxy].object != nullptr && "Proxy already destroyed");
+
+    m_proxies[proxy].object = nullptr;
+    m_freeProxies.push_back(proxy);
+    m_needRebuild = true;
+}
+
+auto Bvh::moveProxy(const ProxyId proxy, const AABB& bounds) -> void
+{
+    m_proxies[proxy].bounds = bounds;
+    m_needRefit = true;
+}
+
+auto Bvh::update() -> void
+{
+    if (m_needRebuild)
+        build();
+    else if (m_needRefit)
+        refit();
+
+    m_needRebuild = false;
+    m_needRefit = false;
+}
+
+auto Bvh::build() -> void
+{
+    m_nodes.clear();
+    m_leafProxies.clear();
+    m_centers.resize(m_proxies.size());
+
+    for (ProxyId i = 0; i < static_cast<ProxyId>(m_proxies.size()); ++i)
+    {
+        if (m_proxies[i].object == nullptr)
+            continue;
+        m_leafProxies.push_back(i);
+        m_centers[i] = m_proxies[i].bounds.center();
+    }
+
+    if (m_leafProxies.empty())
+        return;
+
+    m_nodes.reserve(2 * m_leafProxies.size() / MaxLeafSize + 1);
+    buildNode(0, static_cast<uint32_t>(m_leafProxies.size()), 0);
+}
+
+auto Bvh::buildNode(const uint32_t first, const uint32_t count, const uint32_t depth) -> uint32_t
+{
+    const auto index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    AABB bounds;
+    AABB centerBounds;
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        bounds.expand(m_proxies[m_leafProxies[i]].bounds);
+        centerBounds.expand(m_centers[m_leafProxies[i]]);
+    }
+    m_nodes[index].bounds = bounds;
+
+    const glm::vec3 centerSize = centerBounds.max - centerBounds.min;
+    const int axis = centerSize.x > centerSize.y
+                         ? (centerSize.x > centerSize.z ? 0 : 2)
+                         : (centerSize.y > centerSize.z ? 1 : 2);
+
+    if (count <= MaxLeafSize || centerSize[axis] <= 0.0f)
+    {
+        m_nodes[index].rightOrFirst = first;
+        m_nodes[index].count = count;
+        return index;
+    }
+
+    const auto begin = m_leafProxies.begin() + first;
+    const auto end = begin + count;
+    auto middle = begin + count / 2;
+
+    if (depth < MaxSahDepth)
+    {
+        // Binned surface area heuristic along the axis with the most spread centers
+        Bin bins[BinCount];
+        const float binScale = BinCount / centerSize[axis];
+        const auto binOf = [&](const ProxyId proxy) -> uint32_t
+        {
+            const auto bin = static_cast<uint32_t>((m_centers[proxy][axis] - centerBounds.min[axis]) * binScale);
+            return std::min(bin, BinCount - 1);
+        };
+
+        for (auto it = begin; it != end; ++it)
+        {
+            Bin& bin = bins[binOf(*it)];
+            bin.bounds.expand(m_proxies[*it].bounds);
+            ++bin.count;
+        }
+
+        float rightCosts[BinCount]{};
+        AABB rightBounds;
+        uint32_t rightCount = 0;
+        for (uint32_t i = BinCount - 1; i > 0; --i)
+        {
+            rightBounds.expand(bins[i].bounds);
+            rightCount += bins[i].count;
+            rightCosts[i] = rightBounds.surfaceArea() * static_cast<float>(rightCount);
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        uint32_t bestSplit = 0;
+        AABB leftBounds;
+        uint32_t leftCount = 0;
+        for (uint32_t i = 1; i < BinCount; ++i)
+        {
+            leftBounds.expand(bins[i - 1].bounds);
+            leftCount += bins[i - 1].count;
+            if (leftCount == 0 || leftCount == count)
+                continue;
+
+            const float cost = leftBounds.surfaceArea() * static_cast<float>(leftCount) + rightCosts[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        if (bestSplit > 0)
+            middle = std::partition(begin, end, [&](const ProxyId proxy) { return binOf(proxy) < bestSplit; });
+    }
+
+    if (middle == begin || middle == end)
+    {
+        middle = begin + count / 2;
+        std::nth_element(begin, middle, end, [&](const ProxyId a, const ProxyId b)
+        {
+            return m_centers[a][axis] < m_centers[b][axis];
+        });
+    }
+
+    const auto leftCount = static_cast<uint32_t>(middle - begin);
+    buildNode(first, leftCount, depth + 1);
+    const uint32_t right = buildNode(first + leftCount, count - leftCount, depth + 1);
+
+    m_nodes[index].rightOrFirst = right;
+    m_nodes[index].count = 0;
+    return index;
+}
+
+auto Bvh::refit() -> void
+{
+    // Children are always stored after their parent, so a reverse sweep visits them first
+    for (auto i = static_cast<int64_t>(m_nodes.size()) - 1; i >= 0; --i)
+    {
+        Node& node = m_nodes[i];
+        AABB bounds;
+        if (node.count > 0)
+        {
+            for (uint32_t p = node.rightOrFirst; p < node.rightOrFirst + node.count; ++p)
+                bounds.expand(m_proxies[m_leafProxies[p]].bounds);
+        }
+        else
+        {
+            bounds = m_nodes[i + 1].bounds;
+            bounds.expand(m_nodes[node.rightOrFirst].bounds);
+        }
+        node.bounds = bounds;
+    }
+}
+
+auto Bvh::raycast(const Ray& ray, const float maxDistance) const -> std::optional<RaycastHit>
+{
+    if (m_nodes.empty())
+        return std::nullopt;
+
+    std::optional<RaycastHit> hit;
+    float closest = maxDistance;
+
+    uint32_t stack[64];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.count; ++i)
+            {
+                const Proxy& proxy = m_proxies[m_leafProxies[i]];
+                if (const auto distance = ray.intersects(proxy.bounds, closest))
+                {
+                    closest = *distance;
+                    hit = RaycastHit{proxy.object, *distance};
+                }
+            }
+            continue;
+        }
+
+        // The nearest child is visited first so the farther one can be skipped once something closer is hit
+        const uint32_t index = static_cast<uint32_t>(&node - m_nodes.data());
+        uint32_t nearChild = index + 1;
+        uint32_t farChild = node.rightOrFirst;
+        auto nearDistance = ray.intersects(m_nodes[nearChild].bounds, closest);
+        auto farDistance = ray.intersects(m_nodes[farChild].bounds, closest);
+        if (farDistance && (!nearDistance || *farDistance < *nearDistance))
+        {
+            std::swap(nearChild, farChild);
+            std::swap(nearDistance, farDistance);
+        }
+
+        if (farDistance)
+            stack[stackSize++] = farChild;
+        if (nearDistance)
+            stack[stackSize++] = nearChild;
+    }
+
+    return hit;
+}
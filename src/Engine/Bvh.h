@@ -0,0 +1,134 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "Bounds.h"
+
+class Object;
+
+/**
+ * Bounding volume hierarchy over the world bounds of the engine objects.
+ * Moving a proxy only refits the boxes of the tree, adding or removing one rebuilds it on the next update
+ */
+class Bvh
+{
+public:
+    using ProxyId = int32_t;
+
+    static constexpr ProxyId NullProxy = -1;
+    static constexpr uint32_t MaxLeafSize = 4;
+
+    struct RaycastHit
+    {
+        Object* object;
+        float distance;
+    };
+
+private:
+    struct Proxy
+    {
+        AABB bounds;
+        Object* object; // nullptr when the proxy is free
+    };
+
+    /**
+     * Nodes are stored depth first, so the left child directly follows its parent and every child comes after it
+     */
+    struct Node
+    {
+        AABB bounds;
+        uint32_t rightOrFirst; // Right child index, or first index in m_leafProxies for a leaf
+        uint32_t count; // Proxy count, 0 for an inner node
+    };
+
+    std::vector<Proxy> m_proxies;
+    std::vector<ProxyId> m_freeProxies;
+    std::vector<ProxyId> m_leafProxies;
+    std::vector<Node> m_nodes;
+    std::vector<glm::vec3> m_centers; // Indexed by proxy, only used while building
+
+    bool m_needRebuild{false};
+    bool m_needRefit{false};
+
+    auto build() -> void;
+    auto buildNode(uint32_t first, uint32_t count, uint32_t depth) -> uint32_t;
+    auto refit() -> void;
+
+public:
+    auto createProxy(const AABB& bounds, Object& object) -> ProxyId;
+    auto destroyProxy(ProxyId proxy) -> void;
+    auto moveProxy(ProxyId proxy, const AABB& bounds) -> void;
+
+    /**
+     * Rebuilds or refits the tree after the proxy changes, must be called before querying
+     */
+    auto update() -> void;
+
+    [[nodiscard]] auto proxyCount() const -> size_t { return m_proxies.size() - m_freeProxies.size(); }
+    [[nodiscard]] auto nodeCount() const -> size_t { return m_nodes.size(); }
+
+    /**
+     * Calls visitor with each object whose bounds intersect the frustum, subtrees fully inside it are not tested
+     * further
+     */
+    template <class F>
+    auto queryFrustum(const Frustum& frustum, F&& visitor) const -> void;
+
+    [[nodiscard]] auto raycast(const Ray& ray, float maxDistance = std::numeric_limits<float>::max()) const
+        -> std::optional<RaycastHit>;
+};
+
+template <class F>
+auto Bvh::queryFrustum(const Frustum& frustum, F&& visitor) const -> void
+{
+    if (m_nodes.empty())
+        return;
+
+    uint32_t stack[64];
+    bool stackInside[64];
+    uint32_t stackSize = 0;
+
+    stack[stackSize] = 0;
+    stackInside[stackSize++] = false;
+    while (stackSize > 0)
+    {
+        --stackSize;
+        const Node& node = m_nodes[stack[stackSize]];
+        bool inside = stackInside[stackSize];
+
+        if (!inside)
+        {
+            const auto result = frustum.classify(node.bounds);
+            if (result == Frustum::Outside)
+                continue;
+            inside = result == Frustum::Inside;
+        }
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.count; ++i)
+            {
+                const Proxy& proxy = m_proxies[m_leafProxies[i]];
+                if (inside || node.count == 1 || frustum.intersects(proxy.bounds))
+                    visitor(*proxy.object);
+            }
+            continue;
+        }
+
+        const uint32_t index = static_cast<uint32_t>(&node - m_nodes.data());
+        stack[stackSize] = node.rightOrFirst;
+        stackInside[stackSize++] = inside;
+        stack[stackSize] = index + 1;
+        stackInside[stackSize++] = inside;
+    }
+}
+
+#endif //BVH_H
@@ -0,0 +1,56 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "DeferredImages.h"
+
+auto DeferredImages::Defer(tinygltf::Image*, const int imageId, std::string*, std::string*, int, int,
+                           const unsigned char* bytes, const int size, void* userData) -> bool
+{
+    auto& encoded = static_cast<DeferredImages*>(userData)->m_encoded;
+    if (imageId < 0)
+        return false;
+    if (encoded.size() <= static_cast<size_t>(imageId))
+        encoded.resize(imageId + 1);
+
+    // Copied, the bytes of an external image are freed once the callback returns
+    encoded[imageId].assign(bytes, bytes + size);
+    return true;
+}
+
+auto DeferredImages::install(tinygltf::TinyGLTF& loader) -> void
+{
+    m_encoded.clear();
+    loader.SetImageLoader(&DeferredImages::Defer, this);
+}
+
+auto DeferredImages::decode(tinygltf::Model& model, ThreadPool& pool) -> Expected<size_t, std::string>
+{
+    m_encoded.resize(model.images.size());
+    size_t count = 0;
+    for (const auto& bytes : m_encoded)
+        count += !bytes.empty();
+
+    std::vector<std::string> errors(m_encoded.size());
+
+    // stb_image keeps no global state unless flags are set, images decode independently
+    pool.parallelFor(m_encoded.size(), [&](const size_t i)
+    {
+        auto& bytes = m_encoded[i];
+        if (bytes.empty())
+            return;
+
+        std::string warn;
+        // No user data, the default options, the loader tinygltf installs converts to RGBA the same way
+        if (!tinygltf::LoadImageData(&model.images[i], static_cast<int>(i), &errors[i], &warn, 0, 0, bytes.data(),
+                                     static_cast<int>(bytes.size()), nullptr) && errors[i].empty())
+            errors[i] = "Failed to decode image " + std::to_string(i);
+
+        std::vector<unsigned char>().swap(bytes);
+    });
+
+    for (auto& error : errors)
+        if (!error.empty())
+            return Unexpected(std::move(error));
+    return count;
+}
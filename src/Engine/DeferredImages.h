@@ -0,0 +1,40 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef DEFERREDIMAGES_H
+#define DEFERREDIMAGES_H
+
+#include <string>
+#include <vector>
+
+#include "Expected.h"
+#include "tiny_gltf.h"
+#include "Utility/ThreadPool.h"
+
+/**
+ * Image loader keeping the encoded bytes tinygltf reads instead of decoding them one after the other while parsing.
+ * decode then decodes all the images of the model at once on a pool
+ */
+class DeferredImages
+{
+private:
+    std::vector<std::vector<unsigned char>> m_encoded; // By image index, empty when tinygltf gave no bytes
+
+    static auto Defer(tinygltf::Image* image, int imageId, std::string* err, std::string* warn, int reqWidth,
+                      int reqHeight, const unsigned char* bytes, int size, void* userData) -> bool;
+
+public:
+    /**
+     * The loader must not outlive this
+     */
+    auto install(tinygltf::TinyGLTF& loader) -> void;
+
+    /**
+     * Decodes with the default tinygltf loader, into the images of the model the loader parsed. Returns how many
+     * images were decoded
+     */
+    [[nodiscard]] auto decode(tinygltf::Model& model, ThreadPool& pool) -> Expected<size_t, std::string>;
+};
+
+#endif //DEFERREDIMAGES_H
@@ -0,0 +1,23 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef DRAWUNIFORMS_H
+#define DRAWUNIFORMS_H
+
+#include "glm/glm.hpp"
+
+/**
+ * Mirror of the std140 DrawUniforms block of the default shaders, one slot per draw in the render queue ring buffer
+ */
+struct DrawUniforms
+{
+    glm::mat4 transform{1.0f}; // Unused by instanced draws, which read an attribute instead
+    glm::vec4 baseColorFactor{1.0f};
+    float normalScale{1.0f};
+    float padding[3]{}; // std140 rounds the block size up to a vec4
+};
+
+static_assert(sizeof(DrawUniforms) == sizeof(glm::mat4) + 2 * sizeof(glm::vec4));
+
+#endif //DRAWUNIFORMS_H
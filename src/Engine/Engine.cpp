@@ -2,9 +2,18 @@
 // Created by Simon Cros on 1/13/25.
 //
 
+#include <sstream>
+
 #include "Camera.h"
+#include "DeferredImages.h"
 #include "Engine.h"
+#include "MeshOptimizer.h"
+#include "MeshQuantizer.h"
+#include "ModelCache.h"
+#include "ModelLoad.h"
+#include "Object.h"
 #include "OpenGL/Debug.h"
+#include "OpenGL/Extensions.h"
 
 auto Engine::Create(Window&& window) -> Engine
 {
@@ -17,6 +26,7 @@ Engine::Engine(Window&& window) noexcept :
     m_window.setAsCurrentContext();
     const int version = gladLoadGL(glfwGetProcAddress);
     std::cout << "OpenGL " << GLAD_VERSION_MAJOR(version) << "." << GLAD_VERSION_MINOR(version) << std::endl;
+    Extensions::load();
 
     const bool hasDebugOutput = GLAD_GL_KHR_debug || GLAD_GL_ARB_debug_output;
 
@@ -31,10 +41,8 @@ Engine::Engine(Window&& window) noexcept :
         glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
     }
 
-    // TODO TMP only one global VAO for testing
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    m_frameUniformBuffer = UniformBuffer::Create(static_cast<GLuint>(UniformBlockId::Frame), sizeof(FrameUniforms));
+    m_textureUploads = TextureUploadQueue::Create(TextureUploadBudget);
 
     getWindow().setKeyCallback([](const Window& window, const int key, const int action, int mode) -> void
     {
@@ -64,15 +72,13 @@ auto Engine::run() -> void
     {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        const auto pvMat = m_camera->projectionMatrix() * m_camera->computeViewMatrix();
-        for (auto& [id, shader] : m_shaders)
-        {
-            for (auto& [flags, variant] : shader->programs)
-            {
-                useProgram(*variant.get());
-                variant.get()->setMat4("u_projectionView", pvMat);
-            }
-        }
+        m_frameUniforms.projection = m_camera->projectionMatrix();
+        m_frameUniforms.view = m_camera->computeViewMatrix();
+        m_frameUniforms.projectionView = m_frameUniforms.projection * m_frameUniforms.view;
+        m_frameUniforms.cameraPosition = glm::vec4(m_camera->object().transform().translation, 1.0f);
+        m_frameUniforms.time = m_currentFrameInfo.time.count();
+        m_frameUniformBuffer.write(&m_frameUniforms);
+        m_frustum = Frustum::FromMatrix(m_frameUniforms.projectionView);
 
         for (const auto& object : m_objects)
             object->willUpdate(*this);
@@ -80,8 +86,26 @@ auto Engine::run() -> void
         for (const auto& object : m_objects)
             object->update(*this);
 
-        for (const auto& object : m_objects)
+        updateBounds();
+
+        m_renderStats = {};
+        m_renderStats.uploadedTextureBytes = static_cast<uint32_t>(m_textureUploads.update());
+        m_renderStats.pendingTextures = static_cast<uint32_t>(m_textureUploads.pendingCount());
+        if (m_renderStats.uploadedTextureBytes > 0)
+            forgetBoundTexture();
+        for (Object* object : m_unboundedObjects)
             object->render(*this);
+        m_bvh.queryFrustum(m_frustum, [this](const Object& object) -> void
+        {
+            ++m_renderStats.visibleObjects;
+            object.render(*this);
+        });
+        m_renderStats.culledObjects = static_cast<uint32_t>(m_bvh.proxyCount()) - m_renderStats.visibleObjects;
+
+        m_renderQueue.flush(*this);
+
+        if (m_occlusionCuller)
+            m_occlusionCuller->issueQueries(*this);
 
         for (const auto& object : m_objects)
             object->postRender(*this);
@@ -96,6 +120,40 @@ auto Engine::run() -> void
     }
 }
 
+auto Engine::forgetBoundTexture() -> void
+{
+    // GL_TEXTURE0 is active until the first bindTexture
+    const GLenum target = m_currentBoundTextureTarget != 0 ? m_currentBoundTextureTarget : GL_TEXTURE0;
+    m_currentTextures[target - GL_TEXTURE0] = 0;
+}
+
+auto Engine::updateBounds() -> void
+{
+    m_unboundedObjects.clear();
+    for (const auto& object : m_objects)
+    {
+        const AABB previousBounds = object->m_worldBounds;
+        object->updateBounds(*this);
+        const AABB& bounds = object->m_worldBounds;
+
+        if (bounds.empty())
+        {
+            if (object->m_bvhProxy != Bvh::NullProxy)
+            {
+                m_bvh.destroyProxy(object->m_bvhProxy);
+                object->m_bvhProxy = Bvh::NullProxy;
+            }
+            m_unboundedObjects.push_back(object.get());
+        }
+        else if (object->m_bvhProxy == Bvh::NullProxy)
+            object->m_bvhProxy = m_bvh.createProxy(bounds, *object);
+        else if (bounds != previousBounds)
+            m_bvh.moveProxy(object->m_bvhProxy, bounds);
+    }
+
+    m_bvh.update();
+}
+
 auto Engine::makeShaderVariants(const std::string_view& id, const std::string& vertPath,
                                 const std::string& fragPath) -> Expected<ShaderProgramVariantsRef, std::string>
 {
@@ -113,44 +171,134 @@ auto Engine::makeShaderVariants(const std::string_view& id, const std::string& v
     return *it->second;
 }
 
-auto Engine::loadModel(const std::string_view& id, const std::string& path,
-                       const bool binary) -> Expected<ModelRef, std::string>
+auto Engine::initOcclusionCulling(const std::string& vertPath, const std::string& fragPath)
+    -> Expected<void, std::string>
+{
+    auto e_occlusionCuller = OcclusionCuller::Create(vertPath, fragPath);
+    if (!e_occlusionCuller)
+        return Unexpected(std::move(e_occlusionCuller).error());
+
+    m_occlusionCuller.emplace(*std::move(e_occlusionCuller));
+    m_currentVertexArray = 0; // The cube vertex array was bound while created
+    return {};
+}
+
+static auto importModel(const std::string& path, const bool binary, const MeshOptions& options, ThreadPool& pool,
+                        PreparedModel& prepared) -> Expected<void, std::string>
 {
     std::string err;
     std::string warn;
 
-    tinygltf::Model rawModel;
+    // A loader per import, loads run concurrently on the engine workers
+    tinygltf::TinyGLTF loader;
+    DeferredImages images;
+    images.install(loader);
+    auto& rawModel = prepared.model;
     bool loadResult = binary
-                          ? m_loader.LoadBinaryFromFile(&rawModel, &err, &warn, path)
-                          : m_loader.LoadASCIIFromFile(&rawModel, &err, &warn, path);
+                          ? loader.LoadBinaryFromFile(&rawModel, &err, &warn, path)
+                          : loader.LoadASCIIFromFile(&rawModel, &err, &warn, path);
 
     if (!loadResult)
         return Unexpected(std::move(err));
 
+    std::ostringstream log;
     if (!warn.empty())
-        std::cout << "[WARN] " << warn << std::endl;
+        log << "[WARN] " << warn << "\n";
 
-    auto model = Mesh::Create(std::move(rawModel));
+    const auto decodeStart = ClockType::now();
+    auto e_decoded = images.decode(rawModel, pool);
+    if (!e_decoded)
+        return Unexpected(std::move(e_decoded).error());
+    const auto decodeTime = std::chrono::duration<float, std::milli>(ClockType::now() - decodeStart).count();
+    log << "[INFO] " << *e_decoded << " images decoded in " << decodeTime << " ms\n";
 
-    const auto& modelRenderInfo = model.renderInfo();
-    for (size_t i = 0; i < model.model().meshes.size(); i++)
+    if (options.optimizeIndices)
     {
-        const auto& mesh = model.model().meshes[i];
-        const auto& meshRenderInfo = modelRenderInfo.meshes[i];
+        // A cooked model already keeps the optimized buffers, a second copy would only be read when both are stale
+        std::string cacheLog;
+        const auto optimization = options.cook
+                                      ? MeshOptimizer::Optimize(rawModel)
+                                      : MeshOptimizer::OptimizeCached(rawModel, path + ".optimized", cacheLog);
+        log << cacheLog << "[INFO] " << optimization.primitives << " primitives reordered (" << optimization.fetchReordered
+            << " with their vertices), ACMR " << optimization.acmrBefore << " -> " << optimization.acmrAfter
+            << " over " << optimization.triangles << " triangles" << (optimization.cached ? " (cached)" : "") << "\n";
+    }
 
-        for (size_t j = 0; j < mesh.primitives.size(); j++)
-        {
-            const auto& primitiveRenderInfo = meshRenderInfo.primitives[j];
-            if (!m_vertexArrays.contains(primitiveRenderInfo.vertexArrayFlags))
-            {
-                m_vertexArrays.emplace(std::piecewise_construct,
-                                       std::forward_as_tuple(primitiveRenderInfo.vertexArrayFlags),
-                                       std::forward_as_tuple(
-                                           VertexArray::Create(primitiveRenderInfo.vertexArrayFlags)));
-            }
-        }
+    // After the index optimizer, which renumbers vertices with the glTF component sizes
+    if (options.quantizeAttributes)
+    {
+        const auto quantization = MeshQuantizer::Quantize(rawModel);
+        log << "[INFO] " << quantization.normals << " normal, " << quantization.texCoords << " texcoord and "
+            << quantization.colors << " color accessors quantized, " << quantization.bytesBefore << " -> "
+            << quantization.bytesAfter << " bytes, max errors " << quantization.maxNormalError << " degrees, "
+            << quantization.maxTexCoordError << " texcoord, " << quantization.maxColorError << " color\n";
     }
 
+    if (options.generateLods)
+        prepared.lods = Mesh::GenerateLods(rawModel, ModelBuffers(rawModel), options.optimizeIndices);
+
+    prepared.log += std::move(log).str();
+    return {};
+}
+
+/**
+ * Everything before the GL uploads, safe to run on any thread
+ */
+static auto prepareModel(const std::string& path, const bool binary, const MeshOptions& options,
+                         ThreadPool& pool) -> Expected<PreparedModel, std::string>
+{
+    const auto start = ClockType::now();
+    const std::string cachePath = path + ".cooked";
+
+    PreparedModel prepared;
+    prepared.cooked = options.cook && ModelCache::Read(cachePath, options, prepared.model, prepared.lods,
+                                                       prepared.buffers, prepared.log);
+    if (!prepared.cooked)
+    {
+        auto e_import = importModel(path, binary, options, pool, prepared);
+        if (!e_import)
+            return Unexpected(std::move(e_import).error());
+
+        if (options.cook && !ModelCache::Write(cachePath, path, options, prepared.model, prepared.lods))
+            prepared.log += "[WARN] Failed to write the cooked model " + cachePath + "\n";
+        prepared.buffers = ModelBuffers(prepared.model);
+    }
+
+    prepared.prepareTime = std::chrono::duration<float, std::milli>(ClockType::now() - start).count();
+    return prepared;
+}
+
+auto Engine::createModel(const std::string_view& id, PreparedModel&& prepared,
+                         const MeshOptions& options) -> Expected<ModelRef, std::string>
+{
+    // Before Mesh::Create, queued texture uploads read the pixels of the model it keeps
+    if (m_models.contains(id))
+        return Unexpected("A model with the same id already exist");
+
+    const auto start = ClockType::now();
+
+    std::istringstream log(prepared.log);
+    for (std::string line; std::getline(log, line);)
+        std::cout << line.insert(line.find(' ') + 1, std::string(id) + ": ") << std::endl;
+
+    auto model = Mesh::Create(std::move(prepared.model), std::move(prepared.buffers), options,
+                              std::move(prepared.lods), options.streamTextures ? &m_textureUploads : nullptr);
+
+    m_currentVertexArray = 0; // Vertex arrays are baked by Mesh::Create, which leaves none bound
+    forgetBoundTexture(); // Textures too, on the active unit
+
+    const auto& stats = model.bufferStats();
+    std::cout << "[INFO] " << id << ": " << stats.vertexViews << " vertex and " << stats.indexViews
+        << " index buffer views packed in the mesh arenas, " << stats.bufferObjectsSaved << " buffer objects saved, "
+        << stats.uploadedBytes << " bytes uploaded (" << stats.paddingBytes << " of padding), "
+        << stats.skippedBytes << " bytes not read by primitives left on the CPU, " << stats.lodPrimitives
+        << " primitives simplified (" << stats.lodBytes << " bytes of LOD indices)" << std::endl;
+
+    const auto createTime = std::chrono::duration<float, std::milli>(ClockType::now() - start).count();
+    std::cout << "[INFO] " << id << ": " << (prepared.cooked ? "read from the cooked cache" : "imported") << " in "
+        << prepared.prepareTime << " ms, uploaded in " << createTime << " ms, " << model.buffers().mappedBytes()
+        << " bytes mapped" << std::endl;
+
     // C++ 26 will avoid new key allocation if key already exist (remove explicit std::string constructor call).
     // In this function, unnecessary string allocation is not really a problem since we should not try to add two shaders with the same id
     auto [it, inserted] = m_models.try_emplace(std::string(id), std::make_unique<Mesh>(std::move(model)));
@@ -161,6 +309,36 @@ auto Engine::loadModel(const std::string_view& id, const std::string& path,
     return *it->second;
 }
 
+auto Engine::loadModel(const std::string_view& id, const std::string& path,
+                       const bool binary, const MeshOptions& options) -> Expected<ModelRef, std::string>
+{
+    auto e_prepared = prepareModel(path, binary, options, m_loadPool);
+    if (!e_prepared)
+        return Unexpected(std::move(e_prepared).error());
+
+    return createModel(id, *std::move(e_prepared), options);
+}
+
+auto Engine::loadModelAsync(const std::string_view& id, const std::string& path, const bool binary,
+                            const MeshOptions& options) -> ModelLoad
+{
+    // The images of the model are decoded on the same pool, see ThreadPool::parallelFor
+    auto prepared = m_loadPool.submit([this, path, binary, options]
+    {
+        return prepareModel(path, binary, options, m_loadPool);
+    });
+    return {std::string(id), options, std::move(prepared)};
+}
+
+auto Engine::finishModelLoad(ModelLoad&& load) -> Expected<ModelRef, std::string>
+{
+    auto e_prepared = load.m_prepared.get();
+    if (!e_prepared)
+        return Unexpected(std::move(e_prepared).error());
+
+    return createModel(load.m_id, *std::move(e_prepared), load.m_options);
+}
+
 auto Engine::instantiate() -> Object&
 {
     return **m_objects.emplace(std::make_unique<Object>()).first;
@@ -6,18 +6,32 @@
 #define ENGINE_H
 #include <iostream>
 #include <functional>
+#include <unordered_map>
 #include <unordered_set>
 
+#include "AnimatorGroup.h"
+#include "Bounds.h"
+#include "Bvh.h"
 #include "FrameInfo.h"
+#include "FrameUniforms.h"
+#include "MeshOptions.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
 #include "glad/gl.h"
 #include "tiny_gltf.h"
 #include "OpenGL/ShaderProgram.h"
+#include "OpenGL/TextureUploadQueue.h"
+#include "OpenGL/UniformBuffer.h"
 #include "OpenGL/VertexArray.h"
+#include "Utility/ThreadPool.h"
 #include "Window/Window.h"
 
 class Camera;
 class Mesh;
+class ModelLoad;
 class Object;
+struct PreparedModel;
 
 class Engine
 {
@@ -31,10 +45,10 @@ public:
     using ShaderProgramPtr = std::unique_ptr<ShaderProgram>;
 
     static constexpr size_t MaxTextures = 8;
+    static constexpr size_t TextureUploadBudget = 4 * 1024 * 1024; // Bytes of texture rows uploaded per frame
 
 private:
     Window m_window;
-    tinygltf::TinyGLTF m_loader;
 
     ClockType m_clock{};
     TimePoint m_start{};
@@ -42,9 +56,19 @@ private:
     FrameInfo m_currentFrameInfo{};
 
     StringUnorderedMap<ModelPtr> m_models;
+    std::unordered_map<const Mesh*, AnimatorGroup> m_animatorGroups; // Before m_objects, which hold the animators
     StringUnorderedMap<ShaderProgramPtr> m_shaders;
     std::unordered_set<ObjectPtr> m_objects;
-    std::unordered_map<VertexArrayFlags, VertexArray> m_vertexArrays;
+    Bvh m_bvh; // Over the objects with world bounds
+    std::vector<Object*> m_unboundedObjects; // Never culled
+    RenderQueue m_renderQueue;
+
+    FrameUniforms m_frameUniforms;
+    UniformBuffer m_frameUniformBuffer;
+    Frustum m_frustum;
+    std::optional<OcclusionCuller> m_occlusionCuller;
+    RenderStats m_renderStats;
+    TextureUploadQueue m_textureUploads;
 
     bool m_doubleSided{false};
     GLenum m_polygonMode{GL_FILL};
@@ -55,6 +79,13 @@ private:
 
     const Camera* m_camera{nullptr};
 
+    ThreadPool m_loadPool; // Last, joined before the rest of the engine is destroyed
+
+    auto updateBounds() -> void;
+    auto forgetBoundTexture() -> void; // After GL_TEXTURE_2D of the active unit was bound to 0 outside bindTexture
+    auto createModel(const std::string_view& id, PreparedModel&& prepared,
+                     const MeshOptions& options) -> Expected<ModelRef, std::string>;
+
 public:
     static auto Create(Window&& window) -> Engine;
 
@@ -65,6 +96,44 @@ public:
 
     [[nodiscard]] auto frameInfo() const noexcept -> FrameInfo { return m_currentFrameInfo; }
 
+    /**
+     * Uniforms shared by every program, camera and time are overwritten each frame, the lights can be changed here
+     */
+    [[nodiscard]] auto frameUniforms() noexcept -> FrameUniforms& { return m_frameUniforms; }
+
+    /**
+     * Frustum of the camera for the current frame, renderers skip the nodes outside of it
+     */
+    [[nodiscard]] auto frustum() const noexcept -> const Frustum& { return m_frustum; }
+
+    /**
+     * Loads the program drawing the query boxes, renderers marked as occlusion culled then skip the nodes hidden
+     * during the previous frames
+     */
+    [[nodiscard]] auto initOcclusionCulling(const std::string& vertPath, const std::string& fragPath)
+        -> Expected<void, std::string>;
+
+    [[nodiscard]] auto occlusionCuller() -> std::optional<std::reference_wrapper<OcclusionCuller>>
+    {
+        if (!m_occlusionCuller)
+            return std::nullopt;
+        return *m_occlusionCuller;
+    }
+
+    [[nodiscard]] auto bvh() const noexcept -> const Bvh& { return m_bvh; }
+
+    /**
+     * Closest object whose world bounds are hit by the ray, objects without bounds can't be picked
+     */
+    [[nodiscard]] auto raycast(const Ray& ray, const float maxDistance = std::numeric_limits<float>::max()) const
+        -> std::optional<Bvh::RaycastHit>
+    {
+        return m_bvh.raycast(ray, maxDistance);
+    }
+
+    [[nodiscard]] auto renderStats() noexcept -> RenderStats& { return m_renderStats; }
+    [[nodiscard]] auto renderStats() const noexcept -> const RenderStats& { return m_renderStats; }
+
     [[nodiscard]] auto controls() const noexcept -> Controls { return m_window.getCurrentControls(); }
 
     [[nodiscard]] auto isDoubleSided() const noexcept -> bool { return m_doubleSided; }
@@ -111,9 +180,10 @@ public:
         }
     }
 
-    auto bindTexture(const GLuint bindingIndex, const GLuint& texture) -> void
+    auto bindTexture(const GLuint bindingIndex, GLuint texture) -> void
     {
         assert(bindingIndex < MaxTextures);
+        texture = m_textureUploads.resolve(texture);
         if (m_currentTextures[bindingIndex] != texture)
         {
             const GLenum target = GL_TEXTURE0 + bindingIndex;
@@ -129,10 +199,13 @@ public:
         }
     }
 
-    auto getVertexArray(const VertexArrayFlags flags) -> VertexArray&
-    {
-        return m_vertexArrays[flags];
-    }
+    [[nodiscard]] auto renderQueue() noexcept -> RenderQueue& { return m_renderQueue; }
+
+    /**
+     * Group of the animators of mesh, see Animator. References stay valid until releaseAnimatorGroup
+     */
+    [[nodiscard]] auto animatorGroup(const Mesh& mesh) -> AnimatorGroup& { return m_animatorGroups[&mesh]; }
+    auto releaseAnimatorGroup(const Mesh& mesh) -> void { m_animatorGroups.erase(&mesh); }
 
     [[nodiscard]]
     auto
@@ -141,9 +214,25 @@ public:
 
     [[nodiscard]]
     auto
-    loadModel(const std::string_view& id, const std::string& path, bool binary)
+    loadModel(const std::string_view& id, const std::string& path, bool binary, const MeshOptions& options = {})
         -> Expected<ModelRef, std::string>;
 
+    /**
+     * Parses, imports or reads the cooked model on the engine workers, finishModelLoad does the GL uploads. Loads
+     * started together overlap their file reads and import passes
+     */
+    [[nodiscard]]
+    auto
+    loadModelAsync(const std::string_view& id, const std::string& path, bool binary, const MeshOptions& options = {})
+        -> ModelLoad;
+
+    /**
+     * Waits for the workers and creates the model, on the context thread
+     */
+    [[nodiscard]]
+    auto
+    finishModelLoad(ModelLoad&& load) -> Expected<ModelRef, std::string>;
+
     [[nodiscard]]
     auto
     instantiate()
@@ -5,6 +5,7 @@
 #ifndef ENGINECOMPONENT_H
 #define ENGINECOMPONENT_H
 
+struct AABB;
 class Engine;
 class Object;
 
@@ -23,6 +24,12 @@ public:
 
     virtual auto onWillUpdate(Engine& engine) -> void {}
     virtual auto onUpdate(Engine& engine) -> void {}
+
+    /**
+     * Expands bounds with the world bounds of what the component renders, called between the update and render
+     * phases. Returning false means the component renders something of unknown extent, so the object is never culled
+     */
+    virtual auto onUpdateBounds(Engine& engine, AABB& bounds) -> bool { return true; }
     virtual auto onRender(Engine& engine) -> void {}
     virtual auto onPostRender(Engine& engine) -> void {}
 };
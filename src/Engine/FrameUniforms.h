@@ -0,0 +1,28 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include "glm/glm.hpp"
+
+/**
+ * Mirror of the std140 FrameUniforms block of the default shaders, written once per frame
+ */
+struct FrameUniforms
+{
+    glm::mat4 projection{1.0f};
+    glm::mat4 view{1.0f};
+    glm::mat4 projectionView{1.0f};
+    glm::vec4 cameraPosition{0.0f}; // w unused
+    glm::vec4 lightPosition{-500.0f, 500.0f, -250.0f, 0.0f}; // w unused
+    glm::vec4 lightColor{1.0f, 1.0f, 1.0f, 0.0f}; // w unused
+    glm::vec4 ambientColor{1.0f, 1.0f, 1.0f, 0.5f}; // w is the ambient factor
+    float time{0.0f};
+    float padding[3]{}; // std140 rounds the block size up to a vec4
+};
+
+static_assert(sizeof(FrameUniforms) == 3 * sizeof(glm::mat4) + 5 * sizeof(glm::vec4));
+
+#endif //FRAMEUNIFORMS_H
@@ -2,39 +2,68 @@
 // Created by Simon Cros on 26/01/2025.
 //
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
 
 #include "HumanGLConfig.h"
 #include "Mesh.h"
+#include "MeshQuantizer.h"
 
 #include "OpenGL/ShaderProgram.h"
+#include "Utility/IndexOptimizer.h"
+#include "Utility/MeshSimplifier.h"
+#include "glm/gtx/matrix_decompose.hpp"
 
-static auto addBuffer(const tinygltf::Model& model, const size_t accessorId,
-                      std::vector<GLuint>& buffers) -> GLuint
+// Part of the original triangles kept by each simplified level
+static constexpr std::array<float, MaxLodLevels - 1> LodTriangleRatios{0.5f, 0.25f, 0.125f};
+static constexpr size_t MinLodTriangles = 64; // Smaller primitives are not worth simplifying
+static constexpr float LodMaxRelativeError = 0.05f; // Of the primitive bounding box diagonal
+
+static void* bufferOffset(const size_t offset)
 {
-    GLuint glBuffer = 0;
+    return reinterpret_cast<void*>(offset);
+}
 
-    const auto& accessor = model.accessors[accessorId];
-    glBuffer = buffers[accessor.bufferView];
-    if (glBuffer > 0)
-        return glBuffer;
+static auto bakeVertexArray(const tinygltf::Model& model, const ModelRenderInfo& renderInfo,
+                            const tinygltf::Primitive& primitive, const VertexArrayFlags flags) -> VertexArray
+{
+    auto vertexArray = VertexArray::Create(flags);
 
-    const auto& bufferView = model.bufferViews[accessor.bufferView];
-    const auto& buffer = model.buffers[bufferView.buffer];
+    for (const auto& [attribute, accessorIndex] : primitive.attributes)
+    {
+        const int attributeLocation = VertexArray::getAttributeLocation(attribute);
+        if (attributeLocation == -1)
+            continue;
 
-    if (bufferView.target == 0)
-        return 0; // Can be ignored for this project
+        const auto& accessor = model.accessors[accessorIndex];
+        const auto& accessorRenderInfo = renderInfo.accessors[accessorIndex];
+        if (accessorRenderInfo.bufferId == 0)
+        {
+            // Nothing was uploaded for an accessor without a bufferView, the attribute reads its constant value
+            glDisableVertexAttribArray(attributeLocation);
+            continue;
+        }
 
-    glGenBuffers(1, &glBuffer);
-    glBindBuffer(bufferView.target, glBuffer);
-    glBufferData(bufferView.target, bufferView.byteLength, &buffer.data.at(0) + bufferView.byteOffset, GL_STATIC_DRAW);
+        VertexArray::bindArrayBuffer(accessorRenderInfo.bufferId);
+        glVertexAttribPointer(attributeLocation,
+                              accessorRenderInfo.componentCount,
+                              accessor.componentType,
+                              accessor.normalized ? GL_TRUE : GL_FALSE,
+                              accessorRenderInfo.byteStride,
+                              bufferOffset(accessorRenderInfo.byteOffset));
+    }
+
+    if (primitive.indices >= 0)
+        vertexArray.bindElementArrayBuffer(renderInfo.accessors[primitive.indices].bufferId);
 
-    buffers[accessor.bufferView] = glBuffer;
-    return glBuffer;
+    glBindVertexArray(0);
+    return vertexArray;
 }
 
 static auto loadTexture(const tinygltf::Model& model, const int& textureId, std::vector<GLuint>& textures,
-                        const GLint internalFormat) -> void
+                        const GLint internalFormat, TextureUploadQueue* uploads) -> void
 {
     if (textures[textureId] > 0)
         return;
@@ -94,22 +123,522 @@ static auto loadTexture(const tinygltf::Model& model, const int& textureId, std:
             type = GL_UNSIGNED_INT;
         }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format,
-                     type, image.image.data());
-        glGenerateMipmap(GL_TEXTURE_2D);
+        if (uploads != nullptr)
+        {
+            uploads->enqueue(glTexture, internalFormat, image.width, image.height, format, type, image.image);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format,
+                         type, image.image.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
     }
 
     textures[textureId] = glTexture;
 }
 
-auto Mesh::Create(tinygltf::Model&& model) -> Mesh
+auto Mesh::initRestPose(const tinygltf::Model& model) -> Pose
+{
+    Pose pose;
+
+    pose.resize(model.nodes.size());
+    for (size_t i = 0; i < model.nodes.size(); i++)
+    {
+        const auto& node = model.nodes[i];
+
+        if (!node.matrix.empty())
+        {
+            // glTF requires node matrices to be decomposable to TRS
+            const auto matrix = glm::mat4(node.matrix[0], node.matrix[1], node.matrix[2], node.matrix[3],
+                                          node.matrix[4], node.matrix[5], node.matrix[6], node.matrix[7],
+                                          node.matrix[8], node.matrix[9], node.matrix[10], node.matrix[11],
+                                          node.matrix[12], node.matrix[13], node.matrix[14], node.matrix[15]);
+            glm::vec3 skew;
+            glm::vec4 perspective;
+            glm::decompose(matrix, pose.scales[i], pose.rotations[i], pose.translations[i], skew, perspective);
+            continue;
+        }
+
+        if (!node.translation.empty())
+            pose.translations[i] = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+        if (!node.rotation.empty())
+            pose.rotations[i] = glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+        if (!node.scale.empty())
+            pose.scales[i] = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+    }
+
+    return pose;
+}
+
+auto Mesh::initFlatNodes(const tinygltf::Model& model) -> std::vector<FlatNode>
+{
+    std::vector<FlatNode> flatNodes;
+    std::vector<std::pair<int, int>> stack; // glTF node index, flat parent index
+
+    if (model.scenes.empty())
+        return flatNodes;
+
+    const auto& scene = model.scenes[std::max(model.defaultScene, 0)];
+    flatNodes.reserve(model.nodes.size());
+
+    // Depth first, so every subtree is also contiguous
+    for (auto it = scene.nodes.rbegin(); it != scene.nodes.rend(); ++it)
+        stack.emplace_back(*it, -1);
+    while (!stack.empty())
+    {
+        const auto [nodeIndex, parent] = stack.back();
+        stack.pop_back();
+
+        const auto& node = model.nodes[nodeIndex];
+        const int flatIndex = static_cast<int>(flatNodes.size());
+        flatNodes.push_back({.node = nodeIndex, .parent = parent, .mesh = node.mesh});
+
+        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it)
+            stack.emplace_back(*it, flatIndex);
+    }
+
+    return flatNodes;
+}
+
+/**
+ * Stride of the elements appended by appendAccessorData, on 4 bytes boundaries, vertex fetch prefers aligned
+ * attributes, e.g. the vec3 colors of MeshQuantizer keep their padding byte
+ */
+static auto streamStride(const int componentType, const int componentCount) -> size_t
+{
+    const size_t elementSize = MeshQuantizer::ComponentSize(componentType) * componentCount;
+    return (elementSize + 3) & ~static_cast<size_t>(3);
+}
+
+static auto appendAccessorData(const tinygltf::Model& model, const ModelBuffers& buffers,
+                               const tinygltf::Accessor& accessor, std::vector<unsigned char>& stream) -> void
+{
+    const auto& bufferView = model.bufferViews[accessor.bufferView];
+    const auto buffer = buffers[bufferView.buffer];
+
+    const int componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+    const size_t elementSize = MeshQuantizer::ComponentSize(accessor.componentType) * componentCount;
+    const size_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : elementSize;
+    const size_t destinationStride = streamStride(accessor.componentType, componentCount);
+    const unsigned char* source = buffer.data() + bufferView.byteOffset + accessor.byteOffset;
+
+    const size_t base = stream.size();
+    stream.resize(base + accessor.count * destinationStride);
+    for (size_t i = 0; i < accessor.count; ++i)
+        std::memcpy(stream.data() + base + (i * destinationStride), source + (i * stride), elementSize);
+}
+
+template <typename T>
+static auto appendIndices(const unsigned char* source, const size_t count, const size_t stride,
+                          std::vector<GLuint>& indices) -> void
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        T index;
+        std::memcpy(&index, source + (i * stride), sizeof(T));
+        indices.push_back(index);
+    }
+}
+
+static auto appendIndexData(const tinygltf::Model& model, const ModelBuffers& buffers,
+                            const tinygltf::Accessor& accessor, std::vector<GLuint>& indices) -> void
+{
+    const auto& bufferView = model.bufferViews[accessor.bufferView];
+    const auto buffer = buffers[bufferView.buffer];
+
+    const size_t componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+    const size_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : componentSize;
+    const unsigned char* source = buffer.data() + bufferView.byteOffset + accessor.byteOffset;
+
+    // Merged groups always use 32 bits indices, so primitives of any index type can share them
+    if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+        appendIndices<uint8_t>(source, accessor.count, stride, indices);
+    else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+        appendIndices<uint16_t>(source, accessor.count, stride, indices);
+    else
+        appendIndices<uint32_t>(source, accessor.count, stride, indices);
+}
+
+auto Mesh::initMeshBounds(const tinygltf::Model& model) -> std::vector<AABB>
+{
+    std::vector<AABB> bounds(model.meshes.size());
+
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        for (const auto& primitive : model.meshes[i].primitives)
+        {
+            const auto positionIt = primitive.attributes.find("POSITION");
+            if (positionIt == primitive.attributes.end())
+                continue;
+
+            // glTF requires min and max on POSITION accessors, without them the mesh is never culled
+            const auto& accessor = model.accessors[positionIt->second];
+            if (accessor.minValues.size() < 3 || accessor.maxValues.size() < 3)
+            {
+                bounds[i] = {};
+                break;
+            }
+
+            bounds[i].expand(glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]));
+            bounds[i].expand(glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]));
+        }
+    }
+
+    return bounds;
+}
+
+auto Mesh::GenerateLods(const tinygltf::Model& model, const ModelBuffers& buffers,
+                        const bool optimizeOrder) -> MeshLods
+{
+    MeshLods lods;
+    std::vector<unsigned char> positionData;
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices;
+
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        const auto& mesh = model.meshes[i];
+        for (size_t j = 0; j < mesh.primitives.size(); j++)
+        {
+            const auto& primitive = mesh.primitives[j];
+            const auto positionIt = primitive.attributes.find("POSITION");
+            if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices < 0 ||
+                positionIt == primitive.attributes.end())
+                continue;
+
+            const auto& positionAccessor = model.accessors[positionIt->second];
+            const auto& indexAccessor = model.accessors[primitive.indices];
+            if (positionAccessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+                positionAccessor.type != TINYGLTF_TYPE_VEC3 || indexAccessor.count / 3 < MinLodTriangles)
+                continue;
+
+            positionData.clear();
+            appendAccessorData(model, buffers, positionAccessor, positionData);
+            positions.resize(positionAccessor.count);
+            std::memcpy(positions.data(), positionData.data(), positionData.size());
+
+            indices.clear();
+            appendIndexData(model, buffers, indexAccessor, indices);
+
+            AABB bounds;
+            for (const auto& position : positions)
+                bounds.expand(position);
+            const float maxError = glm::length(bounds.max - bounds.min) * LodMaxRelativeError;
+
+            // Offsets are relative to the start of the LOD indices until they are appended to the index arena
+            PrimitiveLods primitiveLods{.mesh = i, .primitive = j, .levels = {}};
+            for (auto& level : simplifyMeshLevels(positions, indices, LodTriangleRatios, maxError))
+            {
+                // Collapses leave the triangles in source order, the LOD levels are reordered like the full mesh
+                if (optimizeOrder)
+                {
+                    const auto clusters = optimizeVertexCache(level.indices, positions.size());
+                    optimizeOverdraw(level.indices, positions, clusters);
+                }
+
+                primitiveLods.levels.push_back({
+                    .indexCount = static_cast<GLsizei>(level.indices.size()),
+                    .byteOffset = static_cast<GLintptr>(lods.indices.size() * sizeof(GLuint)),
+                    .firstIndex = 0,
+                    .error = level.error,
+                });
+                lods.indices.insert(lods.indices.end(), level.indices.begin(), level.indices.end());
+            }
+
+            if (!primitiveLods.levels.empty())
+                lods.primitives.push_back(std::move(primitiveLods));
+        }
+    }
+
+    return lods;
+}
+
+auto Mesh::initMergedGroups(const tinygltf::Model& model, const ModelBuffers& buffers, ModelRenderInfo& renderInfo,
+                            const std::vector<GLuint>& lodIndices) -> void
+{
+    static constexpr size_t MaxLocations = 4;
+
+    struct AttributeFormat
+    {
+        int componentType{0};
+        int componentCount{0};
+        bool normalized{false};
+
+        auto operator==(const AttributeFormat& other) const -> bool = default;
+    };
+
+    struct Layout
+    {
+        int mode;
+        VertexArrayFlags flags;
+        std::array<AttributeFormat, MaxLocations> attributes; // Per location
+
+        auto operator==(const Layout& other) const -> bool = default;
+    };
+
+    struct GroupData
+    {
+        Layout layout;
+        std::array<std::vector<unsigned char>, MaxLocations> streams;
+        std::vector<GLuint> indices;
+        GLint vertexCount{0};
+    };
+
+    std::vector<GroupData> groups;
+
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        const auto& mesh = model.meshes[i];
+        for (size_t j = 0; j < mesh.primitives.size(); j++)
+        {
+            const auto& primitive = mesh.primitives[j];
+            auto& primitiveRenderInfo = renderInfo.meshes[i].primitives[j];
+
+            const auto positionIt = primitive.attributes.find("POSITION");
+            if (primitive.indices < 0 || positionIt == primitive.attributes.end() ||
+                model.accessors[primitive.indices].bufferView < 0)
+                continue;
+
+            // Accessors without a bufferView have nothing to copy into the streams, the primitive keeps its own arrays
+            const bool hasViews = std::ranges::all_of(primitive.attributes, [&](const auto& attribute)
+            {
+                return VertexArray::getAttributeLocation(attribute.first) == -1 ||
+                    model.accessors[attribute.second].bufferView >= 0;
+            });
+            if (!hasViews)
+                continue;
+
+            Layout layout{.mode = primitive.mode, .flags = primitiveRenderInfo.vertexArrayFlags, .attributes = {}};
+            for (const auto& [attribute, accessorIndex] : primitive.attributes)
+            {
+                const int location = VertexArray::getAttributeLocation(attribute);
+                if (location != -1)
+                {
+                    const auto& accessor = model.accessors[accessorIndex];
+                    layout.attributes[location] = {
+                        .componentType = accessor.componentType,
+                        .componentCount = tinygltf::GetNumComponentsInType(accessor.type),
+                        .normalized = accessor.normalized,
+                    };
+                }
+            }
+
+            auto groupIt = std::ranges::find(groups, layout, &GroupData::layout);
+            if (groupIt == groups.end())
+                groupIt = groups.insert(groups.end(), GroupData{.layout = layout});
+
+            for (const auto& [attribute, accessorIndex] : primitive.attributes)
+            {
+                const int location = VertexArray::getAttributeLocation(attribute);
+                if (location != -1)
+                    appendAccessorData(model, buffers, model.accessors[accessorIndex], groupIt->streams[location]);
+            }
+
+            primitiveRenderInfo.mergedGroup = static_cast<int>(groupIt - groups.begin());
+            primitiveRenderInfo.firstIndex = static_cast<GLuint>(groupIt->indices.size());
+            primitiveRenderInfo.baseVertex = groupIt->vertexCount;
+            appendIndexData(model, buffers, model.accessors[primitive.indices], groupIt->indices);
+            primitiveRenderInfo.indexCount = static_cast<GLuint>(groupIt->indices.size()) -
+                primitiveRenderInfo.firstIndex;
+
+            for (auto& lod : primitiveRenderInfo.lods)
+            {
+                const auto lodIt = lodIndices.begin() + lod.byteOffset / static_cast<GLintptr>(sizeof(GLuint));
+                lod.firstIndex = static_cast<GLuint>(groupIt->indices.size());
+                groupIt->indices.insert(groupIt->indices.end(), lodIt, lodIt + lod.indexCount);
+            }
+
+            groupIt->vertexCount += static_cast<GLint>(model.accessors[positionIt->second].count);
+        }
+    }
+
+    renderInfo.mergedGroups.reserve(groups.size());
+    for (const auto& group : groups)
+    {
+        MergedGroup mergedGroup;
+        mergedGroup.mode = group.layout.mode;
+
+        // One attribute stream after the other, each starting on a 4 bytes boundary
+        std::array<size_t, MaxLocations> streamOffsets{};
+        size_t vertexDataSize = 0;
+        for (size_t location = 0; location < MaxLocations; ++location)
+        {
+            streamOffsets[location] = vertexDataSize;
+            vertexDataSize += (group.streams[location].size() + 3) & ~static_cast<size_t>(3);
+        }
+
+        glGenBuffers(1, &mergedGroup.vertexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mergedGroup.vertexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(vertexDataSize), nullptr, GL_STATIC_DRAW);
+        for (size_t location = 0; location < MaxLocations; ++location)
+        {
+            glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(streamOffsets[location]),
+                            static_cast<GLsizeiptr>(group.streams[location].size()), group.streams[location].data());
+        }
+
+        glGenBuffers(1, &mergedGroup.indexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mergedGroup.indexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(group.indices.size() * sizeof(GLuint)),
+                     group.indices.data(), GL_STATIC_DRAW);
+
+        mergedGroup.vertexArray = VertexArray::Create(group.layout.flags | VertexArrayHasInstanceTransform);
+        VertexArray::bindArrayBuffer(mergedGroup.vertexBuffer);
+        for (size_t location = 0; location < MaxLocations; ++location)
+        {
+            const auto& format = group.layout.attributes[location];
+            if (format.componentCount > 0)
+            {
+                const auto stride = static_cast<GLsizei>(streamStride(format.componentType, format.componentCount));
+                glVertexAttribPointer(static_cast<GLuint>(location), format.componentCount, format.componentType,
+                                      format.normalized ? GL_TRUE : GL_FALSE, stride,
+                                      bufferOffset(streamOffsets[location]));
+            }
+        }
+        mergedGroup.vertexArray.bindElementArrayBuffer(mergedGroup.indexBuffer);
+        glBindVertexArray(0);
+
+        renderInfo.mergedGroups.push_back(std::move(mergedGroup));
+    }
+}
+
+auto Mesh::packBufferViews(const tinygltf::Model& model, const ModelBuffers& buffers, ModelRenderInfo& renderInfo,
+                           const std::vector<GLuint>& lodIndices, GLuint& vertexBuffer,
+                           GLuint& indexBuffer) -> MeshBufferStats
+{
+    enum class Usage : unsigned char { None, Vertex, Index };
+
+    MeshBufferStats stats;
+
+    // Classify the views by how primitives read them, the target of the view is optional in glTF. Accessors without
+    // a view (all zeros or only sparse values) have no data to upload
+    std::vector<Usage> usages(model.bufferViews.size(), Usage::None);
+    const auto classify = [&](const int accessorIndex, const Usage usage)
+    {
+        const int bufferView = model.accessors[accessorIndex].bufferView;
+        if (bufferView >= 0)
+            usages[bufferView] = usage;
+    };
+    for (const auto& mesh : model.meshes)
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.indices >= 0)
+                classify(primitive.indices, Usage::Index);
+            for (const auto& [attribute, accessorIndex] : primitive.attributes)
+                classify(accessorIndex, Usage::Vertex);
+        }
+    }
+
+    // Each view starts on a 4 bytes boundary, enough for every component type
+    std::vector<GLintptr> viewOffsets(model.bufferViews.size(), 0);
+    GLsizeiptr vertexSize = 0;
+    GLsizeiptr indexSize = 0;
+    for (size_t i = 0; i < model.bufferViews.size(); i++)
+    {
+        const auto byteLength = static_cast<GLsizeiptr>(model.bufferViews[i].byteLength);
+        if (usages[i] == Usage::None)
+        {
+            stats.skippedBytes += byteLength;
+            continue;
+        }
+
+        GLsizeiptr& arenaSize = usages[i] == Usage::Vertex ? vertexSize : indexSize;
+        const GLsizeiptr alignedSize = (arenaSize + 3) & ~static_cast<GLsizeiptr>(3);
+
+        stats.paddingBytes += alignedSize - arenaSize;
+        stats.uploadedBytes += byteLength;
+        ++(usages[i] == Usage::Vertex ? stats.vertexViews : stats.indexViews);
+
+        viewOffsets[i] = alignedSize;
+        arenaSize = alignedSize + byteLength;
+    }
+
+    // Simplified levels are appended after the index views, already aligned for 32 bits indices
+    const GLsizeiptr lodOffset = (indexSize + 3) & ~static_cast<GLsizeiptr>(3);
+    if (!lodIndices.empty())
+    {
+        stats.lodBytes = lodIndices.size() * sizeof(GLuint);
+        stats.paddingBytes += lodOffset - indexSize;
+        stats.uploadedBytes += stats.lodBytes;
+        indexSize = lodOffset + static_cast<GLsizeiptr>(stats.lodBytes);
+    }
+
+    // Upload through the copy target, binding an element array buffer would modify the bound vertex array
+    const auto createArena = [&](const Usage usage, const GLsizeiptr size) -> GLuint
+    {
+        if (size == 0)
+            return 0;
+
+        GLuint id;
+        glGenBuffers(1, &id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+
+        for (size_t i = 0; i < model.bufferViews.size(); i++)
+        {
+            if (usages[i] != usage)
+                continue;
+
+            const auto& bufferView = model.bufferViews[i];
+            glBufferSubData(GL_COPY_WRITE_BUFFER, viewOffsets[i], static_cast<GLsizeiptr>(bufferView.byteLength),
+                            buffers[bufferView.buffer].data() + bufferView.byteOffset);
+        }
+
+        if (usage == Usage::Index && !lodIndices.empty())
+        {
+            glBufferSubData(GL_COPY_WRITE_BUFFER, lodOffset, static_cast<GLsizeiptr>(stats.lodBytes),
+                            lodIndices.data());
+        }
+
+        return id;
+    };
+
+    vertexBuffer = createArena(Usage::Vertex, vertexSize);
+    indexBuffer = createArena(Usage::Index, indexSize);
+
+    const size_t packedViews = stats.vertexViews + stats.indexViews;
+    const size_t arenas = (vertexBuffer != 0) + (indexBuffer != 0);
+    stats.bufferObjectsSaved = packedViews - arenas;
+
+    for (size_t i = 0; i < model.accessors.size(); i++)
+    {
+        const auto& accessor = model.accessors[i];
+        if (accessor.bufferView < 0)
+            continue; // Keeps bufferId 0
+
+        const Usage usage = usages[accessor.bufferView];
+
+        auto& accessorRenderInfo = renderInfo.accessors[i];
+        if (usage == Usage::Vertex)
+            accessorRenderInfo.bufferId = vertexBuffer;
+        else if (usage == Usage::Index)
+            accessorRenderInfo.bufferId = indexBuffer;
+        accessorRenderInfo.byteOffset = viewOffsets[accessor.bufferView] + static_cast<GLintptr>(accessor.byteOffset);
+    }
+
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        for (size_t j = 0; j < model.meshes[i].primitives.size(); j++)
+        {
+            auto& lods = renderInfo.meshes[i].primitives[j].lods;
+            for (auto& lod : lods)
+                lod.byteOffset += lodOffset;
+            stats.lodPrimitives += !lods.empty();
+        }
+    }
+
+    return stats;
+}
+
+auto Mesh::Create(tinygltf::Model&& model, ModelBuffers&& buffers, const MeshOptions& options,
+                  MeshLods&& lods, TextureUploadQueue* textureUploads) -> Mesh
 {
-    std::vector<GLuint> buffers;
     std::vector<GLuint> textures;
     std::vector<Animation> animations;
     ModelRenderInfo renderInfo;
 
-    buffers.resize(model.bufferViews.size(), 0);
     textures.resize(model.textures.size(), 0);
     renderInfo.meshes = std::make_unique<MeshRenderInfo[]>(model.meshes.size());
     for (size_t i = 0; i < model.meshes.size(); i++)
@@ -127,16 +656,17 @@ auto Mesh::Create(tinygltf::Model&& model) -> Mesh
             VertexArrayFlags vertexArrayFlags = VertexArrayHasNone;
             ShaderFlags shaderFlags = ShaderHasNone;
 
-            if (primitive.indices >= 0)
-                addBuffer(model, primitive.indices, buffers);
-
             for (const auto& [attributeName, accessorId] : primitive.attributes)
             {
                 if (attributeName == "POSITION")
                     vertexArrayFlags |= VertexArrayHasPosition;
 
                 if (attributeName == "NORMAL")
+                {
                     vertexArrayFlags |= VertexArrayHasNormal;
+                    if (model.accessors[accessorId].type == TINYGLTF_TYPE_VEC2)
+                        shaderFlags |= ShaderHasOctahedralNormals;
+                }
 
                 if (attributeName == "COLOR_0")
                 {
@@ -156,7 +686,8 @@ auto Mesh::Create(tinygltf::Model&& model) -> Mesh
                 const auto& material = model.materials[primitive.material];
                 if (material.pbrMetallicRoughness.baseColorTexture.index >= 0)
                 {
-                    loadTexture(model, material.pbrMetallicRoughness.baseColorTexture.index, textures, GL_SRGB_ALPHA);
+                    loadTexture(model, material.pbrMetallicRoughness.baseColorTexture.index, textures, GL_SRGB_ALPHA,
+                                textureUploads);
                     shaderFlags |= ShaderHasBaseColorMap;
                 }
             }
@@ -168,23 +699,54 @@ auto Mesh::Create(tinygltf::Model&& model) -> Mesh
 
     animations.reserve(model.animations.size());
     for (const auto& animation : model.animations)
-        animations.emplace_back(Animation::Create(model, animation));
+        animations.emplace_back(Animation::Create(model, buffers, animation));
 
+    for (auto& [meshIndex, primitiveIndex, levels] : lods.primitives)
+        renderInfo.meshes[meshIndex].primitives[primitiveIndex].lods = std::move(levels);
+
+    // Merged groups copy the LOD indices while their offsets are still relative, before packing
+    if (options.mergeBuffers)
+        initMergedGroups(model, buffers, renderInfo, lods.indices);
+
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
     renderInfo.accessors = std::make_unique<AccessorRenderInfo[]>(model.accessors.size());
+    const auto bufferStats = packBufferViews(model, buffers, renderInfo, lods.indices, vertexBuffer,
+                                             indexBuffer);
+
     for (size_t i = 0; i < model.accessors.size(); i++)
     {
         const auto& accessor = model.accessors[i];
-        const auto& bufferView = model.bufferViews[accessor.bufferView];
+        const size_t byteStride = accessor.bufferView >= 0 ? model.bufferViews[accessor.bufferView].byteStride : 0;
 
         auto& accessorRenderInfo = renderInfo.accessors[i];
-        accessorRenderInfo.bufferId = addBuffer(model, i, buffers);
-        accessorRenderInfo.componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+        accessorRenderInfo.componentSize = MeshQuantizer::ComponentSize(accessor.componentType);
         accessorRenderInfo.componentCount = tinygltf::GetNumComponentsInType(accessor.type);
-        accessorRenderInfo.byteStride = bufferView.byteStride > 0
-                                            ? static_cast<GLsizei>(bufferView.byteStride)
-                                            : accessorRenderInfo.byteStride = accessorRenderInfo.componentSize *
-                                            accessorRenderInfo.componentCount;
+        accessorRenderInfo.byteStride = byteStride > 0
+                                            ? static_cast<GLsizei>(byteStride)
+                                            : accessorRenderInfo.componentSize * accessorRenderInfo.componentCount;
+    }
+
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        const auto& mesh = model.meshes[i];
+        for (size_t j = 0; j < mesh.primitives.size(); j++)
+        {
+            auto& primitiveRenderInfo = renderInfo.meshes[i].primitives[j];
+            primitiveRenderInfo.vertexArray = bakeVertexArray(model, renderInfo, mesh.primitives[j],
+                                                              primitiveRenderInfo.vertexArrayFlags);
+            primitiveRenderInfo.instancedVertexArray = bakeVertexArray(
+                model, renderInfo, mesh.primitives[j],
+                primitiveRenderInfo.vertexArrayFlags | VertexArrayHasInstanceTransform);
+        }
     }
 
-    return {std::move(buffers), std::move(textures), std::move(animations), std::move(renderInfo), std::move(model)};
+    auto restPose = initRestPose(model);
+    auto flatNodes = initFlatNodes(model);
+    auto meshBounds = initMeshBounds(model);
+
+    return {
+        vertexBuffer, indexBuffer, bufferStats, std::move(textures), std::move(animations), std::move(renderInfo),
+        std::move(restPose), std::move(flatNodes), std::move(meshBounds), std::move(model), std::move(buffers)
+    };
 }
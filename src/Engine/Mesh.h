@@ -10,21 +10,77 @@
 
 #include "tiny_gltf.h"
 #include "Animation.h"
+#include "Bounds.h"
+#include "MeshOptions.h"
+#include "ModelBuffers.h"
+#include "Pose.h"
 #include "OpenGL/ShaderProgram.h"
+#include "OpenGL/TextureUploadQueue.h"
 #include "OpenGL/VertexArray.h"
 
 struct AccessorRenderInfo
 {
-    GLuint bufferId{0};
+    GLuint bufferId{0}; // Vertex or index arena of the mesh, 0 when no primitive reads the accessor
+    GLintptr byteOffset{0}; // In the arena, accessor offset included
     GLint componentSize{0};
     GLint componentCount{0};
     GLsizei byteStride{0};
 };
 
+constexpr size_t MaxLodLevels = 4; // Original primitive included
+
+/**
+ * Simplified version of a primitive, drawn with the same vertices
+ */
+struct PrimitiveLod
+{
+    GLsizei indexCount{0}; // GL_UNSIGNED_INT indices
+    GLintptr byteOffset{0}; // In the index arena
+    GLuint firstIndex{0}; // In the index buffer of the merged group, when the primitive is merged
+    float error{0.0f}; // Approximate distance to the original surface, in mesh space
+};
+
+struct PrimitiveLods
+{
+    size_t mesh{0};
+    size_t primitive{0};
+    std::vector<PrimitiveLod> levels;
+};
+
+/**
+ * Simplified levels of the primitives of a model, generated apart from Mesh::Create so they can be cached
+ */
+struct MeshLods
+{
+    std::vector<GLuint> indices; // Of every level, PrimitiveLod::byteOffset is relative to the start of it
+    std::vector<PrimitiveLods> primitives; // Only the simplified ones
+};
+
 struct PrimitiveRenderInfo
 {
     VertexArrayFlags vertexArrayFlags{VertexArrayHasNone};
     ShaderFlags shaderFlags{ShaderHasNone};
+    VertexArray vertexArray; // Attributes and indices bound at load time, drawing only requires to bind it
+    VertexArray instancedVertexArray; // Same, with the instance transform attribute enabled
+
+    int mergedGroup{-1}; // Index in ModelRenderInfo::mergedGroups, -1 when the primitive is not merged
+    GLuint firstIndex{0}; // Location of the primitive in the buffers of its merged group
+    GLuint indexCount{0};
+    GLint baseVertex{0};
+
+    std::vector<PrimitiveLod> lods; // lods[i] is level i + 1, empty when the primitive was not simplified
+};
+
+/**
+ * Primitives sharing a draw mode and vertex layout, with their vertices and indices concatenated in shared buffers so
+ * they can be submitted with one multi draw
+ */
+struct MergedGroup
+{
+    GLenum mode{GL_TRIANGLES};
+    GLuint vertexBuffer{0};
+    GLuint indexBuffer{0}; // GL_UNSIGNED_INT indices
+    VertexArray vertexArray; // With the instance transform attribute, each draw reads its transform by base instance
 };
 
 struct MeshRenderInfo
@@ -32,35 +88,98 @@ struct MeshRenderInfo
     std::unique_ptr<PrimitiveRenderInfo[]> primitives{nullptr};
 };
 
+/**
+ * Node of the default scene in the flattened hierarchy, parents always come before their children
+ */
+struct FlatNode
+{
+    int node{-1}; // glTF node index, also the index in the pose
+    int parent{-1}; // index in the flattened hierarchy, -1 for scene roots
+    int mesh{-1};
+};
+
+/**
+ * How the bufferViews read by primitives were packed in the vertex and index arenas at load time
+ */
+struct MeshBufferStats
+{
+    size_t vertexViews{0};
+    size_t indexViews{0};
+    size_t bufferObjectsSaved{0}; // Compared to one buffer object per bufferView
+    size_t uploadedBytes{0};
+    size_t paddingBytes{0}; // Added to align views in the arenas
+    size_t skippedBytes{0}; // bufferViews no primitive reads, e.g. animation or image data
+    size_t lodPrimitives{0}; // Primitives with simplified levels
+    size_t lodBytes{0}; // Indices of the simplified levels, at the end of the index arena
+};
+
+
 struct ModelRenderInfo
 {
     std::unique_ptr<AccessorRenderInfo[]> accessors{nullptr};
     std::unique_ptr<MeshRenderInfo[]> meshes{nullptr};
+    std::vector<MergedGroup> mergedGroups; // Empty unless the mesh was loaded with merged buffers
 };
 
 class Mesh
 {
 private:
-    std::vector<GLuint> m_buffers;
+    GLuint m_vertexBuffer{0};
+    GLuint m_indexBuffer{0};
+    MeshBufferStats m_bufferStats;
     std::vector<GLuint> m_textures;
     std::vector<Animation> m_animations; // TODO use a pointer to ensure location never change and faster access
     ModelRenderInfo m_renderInfo;
+    Pose m_restPose;
+    std::vector<FlatNode> m_flatNodes;
+    std::vector<AABB> m_meshBounds; // Indexed by glTF mesh, in mesh space
 
     tinygltf::Model m_model;
+    ModelBuffers m_buffers; // Bytes of the model buffers, the animation samplers point into them
 
-public:
-    static auto Create(tinygltf::Model&& model) -> Mesh;
+    static auto initRestPose(const tinygltf::Model& model) -> Pose;
+    static auto initFlatNodes(const tinygltf::Model& model) -> std::vector<FlatNode>;
+    static auto initMeshBounds(const tinygltf::Model& model) -> std::vector<AABB>;
+    static auto initMergedGroups(const tinygltf::Model& model, const ModelBuffers& buffers,
+                                 ModelRenderInfo& renderInfo, const std::vector<GLuint>& lodIndices) -> void;
+    static auto packBufferViews(const tinygltf::Model& model, const ModelBuffers& buffers,
+                                ModelRenderInfo& renderInfo, const std::vector<GLuint>& lodIndices,
+                                GLuint& vertexBuffer, GLuint& indexBuffer) -> MeshBufferStats;
 
-    Mesh(std::vector<GLuint>&& buffers, std::vector<GLuint>&& textures, std::vector<Animation>&& animations,
-         ModelRenderInfo&& renderInfo, tinygltf::Model&& model) :
-        m_buffers(std::move(buffers)), m_textures(std::move(textures)), m_animations(std::move(animations)),
-        m_renderInfo(std::move(renderInfo)), m_model(std::move(model))
+public:
+    /**
+     * Simplifies the triangle primitives, optimizeOrder runs the vertex cache and overdraw passes on the levels
+     */
+    static auto GenerateLods(const tinygltf::Model& model, const ModelBuffers& buffers,
+                             bool optimizeOrder) -> MeshLods;
+
+    /**
+     * With textureUploads, the textures are queued instead of uploaded, their pixels stay in the moved model
+     */
+    static auto Create(tinygltf::Model&& model, ModelBuffers&& buffers, const MeshOptions& options = {},
+                       MeshLods&& lods = {}, TextureUploadQueue* textureUploads = nullptr) -> Mesh;
+
+    Mesh(const GLuint vertexBuffer, const GLuint indexBuffer, const MeshBufferStats& bufferStats,
+         std::vector<GLuint>&& textures, std::vector<Animation>&& animations, ModelRenderInfo&& renderInfo,
+         Pose&& restPose, std::vector<FlatNode>&& flatNodes, std::vector<AABB>&& meshBounds,
+         tinygltf::Model&& model, ModelBuffers&& buffers) :
+        m_vertexBuffer(vertexBuffer), m_indexBuffer(indexBuffer), m_bufferStats(bufferStats),
+        m_textures(std::move(textures)), m_animations(std::move(animations)),
+        m_renderInfo(std::move(renderInfo)), m_restPose(std::move(restPose)), m_flatNodes(std::move(flatNodes)),
+        m_meshBounds(std::move(meshBounds)),
+        m_model(std::move(model)), m_buffers(std::move(buffers))
     {
     }
 
     [[nodiscard]] auto model() const -> const tinygltf::Model& { return m_model; }
 
-    [[nodiscard]] auto buffer(const size_t index) const -> GLuint { return m_buffers[index]; }
+    [[nodiscard]] auto buffers() const -> const ModelBuffers& { return m_buffers; }
+
+    [[nodiscard]] auto vertexBuffer() const -> GLuint { return m_vertexBuffer; }
+
+    [[nodiscard]] auto indexBuffer() const -> GLuint { return m_indexBuffer; }
+
+    [[nodiscard]] auto bufferStats() const -> const MeshBufferStats& { return m_bufferStats; }
 
     [[nodiscard]] auto texture(const size_t index) const -> GLuint { return m_textures[index]; }
 
@@ -68,13 +187,22 @@ public:
 
     [[nodiscard]] auto renderInfo() const -> const ModelRenderInfo& { return m_renderInfo; }
 
-    [[nodiscard]] auto prepareShaderPrograms(ShaderProgram& builder) const -> Expected<void, std::string>
+    [[nodiscard]] auto restPose() const -> const Pose& { return m_restPose; }
+
+    [[nodiscard]] auto flatNodes() const -> const std::vector<FlatNode>& { return m_flatNodes; }
+
+    [[nodiscard]] auto meshBounds() const -> const std::vector<AABB>& { return m_meshBounds; }
+
+    [[nodiscard]] auto merged() const -> bool { return !m_renderInfo.mergedGroups.empty(); }
+
+    [[nodiscard]] auto prepareShaderPrograms(ShaderProgram& builder, const ShaderFlags extraFlags = ShaderHasNone) const
+        -> Expected<void, std::string>
     {
         for (int i = 0; i < m_model.meshes.size(); ++i)
         {
             for (int j = 0; j < m_model.meshes[i].primitives.size(); ++j)
             {
-                auto e_success = builder.enableVariant(m_renderInfo.meshes[i].primitives[j].shaderFlags);
+                auto e_success = builder.enableVariant(m_renderInfo.meshes[i].primitives[j].shaderFlags | extraFlags);
                 if (!e_success)
                     return Unexpected(std::move(e_success).error());
             }
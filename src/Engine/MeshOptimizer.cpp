@@ -0,0 +1,352 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <unordered_set>
+
+#include "Utility/CacheFile.h"
+#include "Utility/Hash.h"
+#include "Utility/IndexOptimizer.h"
+#include "Utility/MappedFile.h"
+
+namespace
+{
+    auto accessorData(tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t& stride) -> unsigned char*
+    {
+        const auto& bufferView = model.bufferViews[accessor.bufferView];
+        const size_t elementSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) *
+            tinygltf::GetNumComponentsInType(accessor.type);
+        stride = bufferView.byteStride > 0 ? bufferView.byteStride : elementSize;
+        return model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset;
+    }
+
+    auto readIndices(tinygltf::Model& model, const tinygltf::Accessor& accessor) -> std::vector<uint32_t>
+    {
+        size_t stride;
+        const unsigned char* data = accessorData(model, accessor, stride);
+        const size_t componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+
+        std::vector<uint32_t> indices(accessor.count, 0);
+        for (size_t i = 0; i < accessor.count; ++i)
+            std::memcpy(&indices[i], data + i * stride, componentSize); // Little endian, like glTF
+        return indices;
+    }
+
+    auto writeIndices(tinygltf::Model& model, const tinygltf::Accessor& accessor,
+                      const std::vector<uint32_t>& indices) -> void
+    {
+        size_t stride;
+        unsigned char* data = accessorData(model, accessor, stride);
+        const size_t componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+
+        for (size_t i = 0; i < accessor.count; ++i)
+            std::memcpy(data + i * stride, &indices[i], componentSize);
+    }
+
+    auto readPositions(tinygltf::Model& model, const tinygltf::Accessor& accessor) -> std::vector<glm::vec3>
+    {
+        std::vector<glm::vec3> positions(accessor.count, glm::vec3(0.0f));
+        if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.type != TINYGLTF_TYPE_VEC3)
+            return positions; // Only used to sort overdraw clusters, which then keep their order
+
+        size_t stride;
+        const unsigned char* data = accessorData(model, accessor, stride);
+        for (size_t i = 0; i < accessor.count; ++i)
+            std::memcpy(&positions[i], data + i * stride, sizeof(glm::vec3));
+        return positions;
+    }
+
+    template <typename T>
+    auto hashValue(const T& value, const uint64_t hash) -> uint64_t
+    {
+        return fnv1a(reinterpret_cast<const unsigned char*>(&value), sizeof(value), hash);
+    }
+
+    auto hashAttributes(const std::map<std::string, int>& attributes, uint64_t hash) -> uint64_t
+    {
+        hash = hashValue(attributes.size(), hash);
+        for (const auto& [name, accessorIndex] : attributes)
+        {
+            hash = fnv1a(reinterpret_cast<const unsigned char*>(name.data()), name.size() + 1, hash);
+            hash = hashValue(accessorIndex, hash);
+        }
+        return hash;
+    }
+
+    /**
+     * Everything Optimize reads besides the buffer bytes: how accessors and bufferViews lay the data out, which
+     * primitives index it and who else reads the vertex accessors
+     */
+    auto layoutHash(const tinygltf::Model& model) -> uint64_t
+    {
+        uint64_t hash = hashValue(model.accessors.size(), Fnv1aOffset);
+        for (const auto& accessor : model.accessors)
+        {
+            for (const auto value : {accessor.bufferView, accessor.componentType, accessor.type,
+                                     static_cast<int>(accessor.sparse.isSparse)})
+                hash = hashValue(value, hash);
+            hash = hashValue(accessor.byteOffset, hash);
+            hash = hashValue(accessor.count, hash);
+        }
+
+        hash = hashValue(model.bufferViews.size(), hash);
+        for (const auto& bufferView : model.bufferViews)
+        {
+            hash = hashValue(bufferView.buffer, hash);
+            for (const auto value : {bufferView.byteOffset, bufferView.byteLength, bufferView.byteStride})
+                hash = hashValue(value, hash);
+        }
+
+        hash = hashValue(model.meshes.size(), hash);
+        for (const auto& mesh : model.meshes)
+        {
+            hash = hashValue(mesh.primitives.size(), hash);
+            for (const auto& primitive : mesh.primitives)
+            {
+                hash = hashValue(primitive.mode, hash);
+                hash = hashValue(primitive.indices, hash);
+                hash = hashAttributes(primitive.attributes, hash);
+                hash = hashValue(primitive.targets.size(), hash);
+                for (const auto& target : primitive.targets)
+                    hash = hashAttributes(target, hash);
+            }
+        }
+
+        hash = hashValue(model.animations.size(), hash);
+        for (const auto& animation : model.animations)
+        {
+            hash = hashValue(animation.samplers.size(), hash);
+            for (const auto& sampler : animation.samplers)
+            {
+                hash = hashValue(sampler.input, hash);
+                hash = hashValue(sampler.output, hash);
+            }
+        }
+
+        hash = hashValue(model.skins.size(), hash);
+        for (const auto& skin : model.skins)
+            hash = hashValue(skin.inverseBindMatrices, hash);
+        return hash;
+    }
+
+    auto permuteAccessor(tinygltf::Model& model, const tinygltf::Accessor& accessor,
+                         const std::vector<uint32_t>& remap) -> void
+    {
+        size_t stride;
+        unsigned char* data = accessorData(model, accessor, stride);
+        const size_t elementSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) *
+            tinygltf::GetNumComponentsInType(accessor.type);
+
+        std::vector<unsigned char> elements(accessor.count * elementSize);
+        for (size_t i = 0; i < accessor.count; ++i)
+            std::memcpy(elements.data() + remap[i] * elementSize, data + i * stride, elementSize);
+        for (size_t i = 0; i < accessor.count; ++i)
+            std::memcpy(data + i * stride, elements.data() + i * elementSize, elementSize);
+    }
+}
+
+// Outside of the anonymous namespace, the cache archives find it by argument dependent lookup
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<MeshOptimizationStats> stats) -> void
+{
+    archive(stats.primitives, stats.fetchReordered, stats.triangles, stats.acmrBefore, stats.acmrAfter);
+}
+
+auto MeshOptimizer::optimizePrimitive(tinygltf::Model& model, const tinygltf::Primitive& primitive,
+                                      const bool reorderVertices, MeshOptimizationStats& stats) -> void
+{
+    const auto& indexAccessor = model.accessors[primitive.indices];
+    const auto& positionAccessor = model.accessors[primitive.attributes.at("POSITION")];
+    const size_t vertexCount = positionAccessor.count;
+
+    auto indices = readIndices(model, indexAccessor);
+    if (std::ranges::any_of(indices, [&](const uint32_t index) { return index >= vertexCount; }))
+        return;
+
+    const float triangles = static_cast<float>(indices.size() / 3);
+    stats.acmrBefore += computeAcmr(indices, vertexCount) * triangles;
+
+    const auto clusters = optimizeVertexCache(indices, vertexCount);
+    optimizeOverdraw(indices, readPositions(model, positionAccessor), clusters);
+    if (reorderVertices)
+    {
+        const auto remap = optimizeVertexFetch(indices, vertexCount);
+        for (const auto& [attribute, accessorIndex] : primitive.attributes)
+            permuteAccessor(model, model.accessors[accessorIndex], remap);
+        ++stats.fetchReordered;
+    }
+
+    stats.acmrAfter += computeAcmr(indices, vertexCount) * triangles;
+    stats.triangles += indices.size() / 3;
+    ++stats.primitives;
+
+    writeIndices(model, indexAccessor, indices);
+}
+
+auto MeshOptimizer::Optimize(tinygltf::Model& model) -> MeshOptimizationStats
+{
+    MeshOptimizationStats stats;
+
+    // Every reader of each accessor, a vertex accessor read elsewhere can't be renumbered
+    std::vector<uint32_t> accessorReaders(model.accessors.size(), 0);
+    for (const auto& mesh : model.meshes)
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.indices >= 0)
+                ++accessorReaders[primitive.indices];
+            for (const auto& [attribute, accessorIndex] : primitive.attributes)
+                ++accessorReaders[accessorIndex];
+            for (const auto& target : primitive.targets)
+            {
+                for (const auto& [attribute, accessorIndex] : target)
+                    ++accessorReaders[accessorIndex];
+            }
+        }
+    }
+    for (const auto& animation : model.animations)
+    {
+        for (const auto& sampler : animation.samplers)
+        {
+            ++accessorReaders[sampler.input];
+            ++accessorReaders[sampler.output];
+        }
+    }
+    for (const auto& skin : model.skins)
+    {
+        if (skin.inverseBindMatrices >= 0)
+            ++accessorReaders[skin.inverseBindMatrices];
+    }
+
+    std::vector<std::vector<int>> bufferViewAccessors(model.bufferViews.size());
+    for (int i = 0; i < static_cast<int>(model.accessors.size()); ++i)
+    {
+        if (model.accessors[i].bufferView >= 0)
+            bufferViewAccessors[model.accessors[i].bufferView].push_back(i);
+    }
+
+    std::unordered_set<int> optimizedIndices;
+    for (const auto& mesh : model.meshes)
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            const auto positionIt = primitive.attributes.find("POSITION");
+            if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices < 0 ||
+                positionIt == primitive.attributes.end())
+                continue;
+
+            const auto& indexAccessor = model.accessors[primitive.indices];
+            if (indexAccessor.bufferView < 0 || indexAccessor.sparse.isSparse ||
+                !optimizedIndices.insert(primitive.indices).second)
+                continue;
+
+            const size_t vertexCount = model.accessors[positionIt->second].count;
+            bool reorderVertices = accessorReaders[primitive.indices] == 1 && primitive.targets.empty();
+            for (const auto& [attribute, accessorIndex] : primitive.attributes)
+            {
+                const auto& accessor = model.accessors[accessorIndex];
+                reorderVertices &= accessorReaders[accessorIndex] == 1 && accessor.bufferView >= 0 &&
+                    !accessor.sparse.isSparse && accessor.count == vertexCount;
+                if (!reorderVertices)
+                    break;
+
+                // Interleaved attributes share their bufferView, any other accessor in it would be scrambled
+                for (const int viewAccessor : bufferViewAccessors[accessor.bufferView])
+                {
+                    reorderVertices &= std::ranges::any_of(primitive.attributes, [&](const auto& attributeAccessor)
+                    {
+                        return attributeAccessor.second == viewAccessor;
+                    });
+                }
+            }
+
+            optimizePrimitive(model, primitive, reorderVertices, stats);
+        }
+    }
+
+    if (stats.triangles > 0)
+    {
+        stats.acmrBefore /= static_cast<float>(stats.triangles);
+        stats.acmrAfter /= static_cast<float>(stats.triangles);
+    }
+    return stats;
+}
+
+auto MeshOptimizer::OptimizeCached(tinygltf::Model& model, const std::string& cachePath, std::string& log)
+    -> MeshOptimizationStats
+{
+    // The layout goes first, identical bytes described by other accessors or primitives optimize differently
+    std::vector<uint64_t> hashes;
+    hashes.reserve(model.buffers.size() + 1);
+    hashes.push_back(layoutHash(model));
+    for (const auto& buffer : model.buffers)
+        hashes.push_back(fnv1a(buffer.data.data(), buffer.data.size()));
+
+    MeshOptimizationStats stats;
+    if (readCache(cachePath, model, hashes, stats))
+        return stats;
+
+    stats = Optimize(model);
+    if (!writeCache(cachePath, model, hashes, stats))
+        log += "[WARN] Failed to write the optimized buffers cache " + cachePath + "\n";
+    return stats;
+}
+
+auto MeshOptimizer::readCache(const std::string& path, tinygltf::Model& model, const std::vector<uint64_t>& hashes,
+                              MeshOptimizationStats& stats) -> bool
+{
+    if (!std::filesystem::exists(path))
+        return false;
+
+    const auto e_mapping = MappedFile::Open(path);
+    if (!e_mapping)
+        return false;
+
+    CacheReader reader(e_mapping->bytes());
+    if (!CacheFile::ReadHeader(reader, CacheMagic, CacheVersion))
+        return false;
+
+    std::vector<uint64_t> cachedHashes;
+    uint64_t bufferCount = 0;
+    reader(cachedHashes, bufferCount);
+    if (reader.failed() || cachedHashes != hashes || bufferCount != model.buffers.size())
+        return false;
+
+    // Buffers are only replaced once the whole file is known to match
+    std::vector<std::span<const unsigned char>> buffers;
+    for (const auto& buffer : model.buffers)
+    {
+        buffers.push_back(reader.blob());
+        if (buffers.back().size() != buffer.data.size())
+            return false;
+    }
+
+    MeshOptimizationStats cachedStats;
+    reader(cachedStats);
+    if (!reader.finished())
+        return false;
+
+    for (size_t i = 0; i < buffers.size(); ++i)
+        model.buffers[i].data.assign(buffers[i].begin(), buffers[i].end());
+    stats = cachedStats;
+    stats.cached = true;
+    return true;
+}
+
+auto MeshOptimizer::writeCache(const std::string& path, const tinygltf::Model& model,
+                               const std::vector<uint64_t>& hashes, const MeshOptimizationStats& stats) -> bool
+{
+    return CacheFile::Write(path, CacheMagic, CacheVersion, [&](CacheWriter& writer)
+    {
+        writer(hashes, static_cast<uint64_t>(model.buffers.size()));
+        for (const auto& buffer : model.buffers)
+            writer.blob(buffer.data);
+        writer(stats);
+    });
+}
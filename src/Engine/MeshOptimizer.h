@@ -0,0 +1,55 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+struct MeshOptimizationStats
+{
+    size_t primitives{0}; // Indexed triangle primitives reordered
+    size_t fetchReordered{0}; // Of them, with their vertices renumbered too
+    size_t triangles{0};
+    float acmrBefore{0.0f}; // Triangle weighted over the primitives
+    float acmrAfter{0.0f};
+    bool cached{false}; // Read from the cache instead of running the passes
+};
+
+/**
+ * Reorders the index and vertex data of a glTF model in place before it is uploaded: vertex cache, overdraw then
+ * vertex fetch order, see Utility/IndexOptimizer.h. Vertices are only renumbered when no other primitive, animation or
+ * skin reads their accessors or bufferViews
+ */
+class MeshOptimizer
+{
+private:
+    static constexpr uint32_t CacheMagic = 0x4F4C4748; // "HGLO"
+    static constexpr uint32_t CacheVersion = 3;
+
+    static auto optimizePrimitive(tinygltf::Model& model, const tinygltf::Primitive& primitive, bool reorderVertices,
+                                  MeshOptimizationStats& stats) -> void;
+    static auto readCache(const std::string& path, tinygltf::Model& model, const std::vector<uint64_t>& hashes,
+                          MeshOptimizationStats& stats) -> bool;
+    static auto writeCache(const std::string& path, const tinygltf::Model& model, const std::vector<uint64_t>& hashes,
+                           const MeshOptimizationStats& stats) -> bool;
+
+public:
+    static auto Optimize(tinygltf::Model& model) -> MeshOptimizationStats;
+
+    /**
+     * Same as Optimize, but the reordered buffers are read from cachePath when it was written for identical source
+     * buffers and accessor, bufferView and primitive layout, else they are written to it for the next load. Warnings
+     * are appended to log, it can run on a worker
+     */
+    static auto OptimizeCached(tinygltf::Model& model, const std::string& cachePath, std::string& log)
+        -> MeshOptimizationStats;
+};
+
+#endif //MESHOPTIMIZER_H
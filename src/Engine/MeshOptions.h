@@ -0,0 +1,19 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MESHOPTIONS_H
+#define MESHOPTIONS_H
+
+struct MeshOptions
+{
+    bool mergeBuffers{false}; // Copy indexed primitives in shared buffers per vertex layout, drawn with multi draw
+    bool generateLods{false}; // Simplify the triangle primitives at load time, see PrimitiveRenderInfo::lods
+    bool optimizeIndices{false}; // Reorder indices and vertices for the GPU caches, see MeshOptimizer
+    bool quantizeAttributes{false}; // Store normals, texcoords and colors in smaller formats, see MeshQuantizer
+    bool cook{false}; // Read the imported model from a binary cache next to the source, see ModelCache
+    bool mapBuffers{false}; // With cook, buffers of a cooked model are read in place from a mapping of the cache
+    bool streamTextures{false}; // Upload the textures over the next frames, see TextureUploadQueue
+};
+
+#endif //MESHOPTIONS_H
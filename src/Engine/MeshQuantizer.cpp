@@ -0,0 +1,246 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "MeshQuantizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+
+namespace
+{
+    enum class Semantic : unsigned char { None, Normal, TexCoord, Color, Shared };
+
+    auto readFloats(const tinygltf::Model& model, const tinygltf::Accessor& accessor) -> std::vector<float>
+    {
+        const auto& bufferView = model.bufferViews[accessor.bufferView];
+        const size_t componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+        const size_t elementSize = componentCount * sizeof(float);
+        const size_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : elementSize;
+        const unsigned char* source = model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset +
+            accessor.byteOffset;
+
+        std::vector<float> values(accessor.count * componentCount);
+        for (size_t i = 0; i < accessor.count; ++i)
+            std::memcpy(values.data() + i * componentCount, source + i * stride, elementSize);
+        return values;
+    }
+
+    auto semanticOf(const std::string& attribute) -> Semantic
+    {
+        if (attribute == "NORMAL")
+            return Semantic::Normal;
+        if (attribute == "TEXCOORD_0")
+            return Semantic::TexCoord;
+        if (attribute == "COLOR_0")
+            return Semantic::Color;
+        return Semantic::Shared; // Any other reader keeps the accessor as is
+    }
+}
+
+auto MeshQuantizer::ComponentSize(const int componentType) -> int
+{
+    return componentType == HalfFloatComponentType ? 2 : tinygltf::GetComponentSizeInBytes(componentType);
+}
+
+auto MeshQuantizer::DecodeOctahedral(const std::array<uint16_t, 2>& encoded) -> glm::vec3
+{
+    glm::vec3 normal(glm::unpackSnorm1x16(encoded[0]), glm::unpackSnorm1x16(encoded[1]), 0.0f);
+    normal.z = 1.0f - std::abs(normal.x) - std::abs(normal.y);
+    const float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
+
+auto MeshQuantizer::EncodeOctahedral(const glm::vec3& normal) -> std::array<uint16_t, 2>
+{
+    const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum == 0.0f)
+        return {0, 0};
+
+    // Project on the octahedron, then fold the lower half over the upper one
+    const glm::vec3 projected = normal / sum;
+    float u = projected.x;
+    float v = projected.y;
+    if (projected.z < 0.0f)
+    {
+        u = (1.0f - std::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f);
+        v = (1.0f - std::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    // The nearest grid point is not always the nearest direction, keep the best of the four around
+    const glm::vec3 target = glm::normalize(normal);
+    std::array<uint16_t, 2> best{};
+    float bestDot = -2.0f;
+    for (int i = 0; i < 4; ++i)
+    {
+        const float x = std::clamp(std::floor(u * 32767.0f) + static_cast<float>(i & 1), -32767.0f, 32767.0f);
+        const float y = std::clamp(std::floor(v * 32767.0f) + static_cast<float>(i >> 1), -32767.0f, 32767.0f);
+        const std::array candidate{glm::packSnorm1x16(x / 32767.0f), glm::packSnorm1x16(y / 32767.0f)};
+
+        const float candidateDot = glm::dot(DecodeOctahedral(candidate), target);
+        if (candidateDot > bestDot)
+        {
+            bestDot = candidateDot;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+auto MeshQuantizer::Quantize(tinygltf::Model& model) -> MeshQuantizationStats
+{
+    MeshQuantizationStats stats;
+
+    // An accessor is only rewritten when every reader uses it as the same attribute
+    std::vector<Semantic> semantics(model.accessors.size(), Semantic::None);
+    const auto addReader = [&](const int accessorIndex, const Semantic semantic)
+    {
+        auto& current = semantics[accessorIndex];
+        current = current == Semantic::None || current == semantic ? semantic : Semantic::Shared;
+    };
+    for (const auto& mesh : model.meshes)
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            for (const auto& [attribute, accessorIndex] : primitive.attributes)
+                addReader(accessorIndex, semanticOf(attribute));
+            for (const auto& target : primitive.targets)
+            {
+                for (const auto& [attribute, accessorIndex] : target)
+                    addReader(accessorIndex, Semantic::Shared);
+            }
+        }
+    }
+    for (const auto& animation : model.animations)
+    {
+        for (const auto& sampler : animation.samplers)
+        {
+            addReader(sampler.input, Semantic::Shared);
+            addReader(sampler.output, Semantic::Shared);
+        }
+    }
+    for (const auto& skin : model.skins)
+    {
+        if (skin.inverseBindMatrices >= 0)
+            addReader(skin.inverseBindMatrices, Semantic::Shared);
+    }
+
+    tinygltf::Buffer quantizedBuffer;
+    quantizedBuffer.name = "quantized";
+    const int quantizedBufferIndex = static_cast<int>(model.buffers.size());
+    std::vector<unsigned char> data;
+
+    for (size_t i = 0; i < model.accessors.size(); ++i)
+    {
+        auto& accessor = model.accessors[i];
+        const Semantic semantic = semantics[i];
+        if (semantic == Semantic::None || semantic == Semantic::Shared ||
+            accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.bufferView < 0 ||
+            accessor.sparse.isSparse)
+            continue;
+
+        const size_t componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+        const auto values = readFloats(model, accessor);
+        size_t byteStride = 0;
+        data.clear();
+
+        if (semantic == Semantic::Normal && accessor.type == TINYGLTF_TYPE_VEC3)
+        {
+            data.resize(accessor.count * 2 * sizeof(uint16_t));
+            for (size_t j = 0; j < accessor.count; ++j)
+            {
+                const glm::vec3 normal(values[j * 3], values[j * 3 + 1], values[j * 3 + 2]);
+                const auto encoded = EncodeOctahedral(normal);
+                std::memcpy(data.data() + j * sizeof(encoded), encoded.data(), sizeof(encoded));
+
+                if (glm::length(normal) > 0.0f)
+                {
+                    const float cosine = std::clamp(glm::dot(DecodeOctahedral(encoded), glm::normalize(normal)),
+                                                    -1.0f, 1.0f);
+                    stats.maxNormalError = std::max(stats.maxNormalError,
+                                                    std::acos(cosine) * 180.0f / std::numbers::pi_v<float>);
+                }
+            }
+
+            accessor.type = TINYGLTF_TYPE_VEC2;
+            accessor.componentType = TINYGLTF_COMPONENT_TYPE_SHORT;
+            accessor.normalized = true;
+            ++stats.normals;
+        }
+        else if (semantic == Semantic::TexCoord && accessor.type == TINYGLTF_TYPE_VEC2)
+        {
+            const auto [minIt, maxIt] = std::ranges::minmax_element(values);
+            const bool unorm = values.empty() || (*minIt >= 0.0f && *maxIt <= 1.0f);
+            if (!unorm && std::max(-*minIt, *maxIt) > MaxHalfTexCoord)
+                continue;
+
+            data.resize(values.size() * sizeof(uint16_t));
+            for (size_t j = 0; j < values.size(); ++j)
+            {
+                const uint16_t packed = unorm ? glm::packUnorm1x16(values[j]) : glm::packHalf1x16(values[j]);
+                const float decoded = unorm ? glm::unpackUnorm1x16(packed) : glm::unpackHalf1x16(packed);
+                std::memcpy(data.data() + j * sizeof(packed), &packed, sizeof(packed));
+                stats.maxTexCoordError = std::max(stats.maxTexCoordError, std::abs(decoded - values[j]));
+            }
+
+            accessor.componentType = unorm ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : HalfFloatComponentType;
+            accessor.normalized = unorm;
+            ++stats.texCoords;
+        }
+        else if (semantic == Semantic::Color &&
+            (accessor.type == TINYGLTF_TYPE_VEC3 || accessor.type == TINYGLTF_TYPE_VEC4))
+        {
+            // Vec3 colors keep a 4 bytes stride, vertex fetch prefers aligned attributes
+            byteStride = accessor.type == TINYGLTF_TYPE_VEC3 ? 4 : 0;
+            data.resize(accessor.count * 4, 0);
+            for (size_t j = 0; j < values.size(); ++j)
+            {
+                const uint8_t packed = glm::packUnorm1x8(values[j]);
+                data[(j / componentCount) * 4 + j % componentCount] = packed;
+                stats.maxColorError = std::max(stats.maxColorError,
+                                               std::abs(glm::unpackUnorm1x8(packed) - values[j]));
+            }
+
+            accessor.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+            accessor.normalized = true;
+            ++stats.colors;
+        }
+        else
+            continue;
+
+        // Each view starts on a 4 bytes boundary, like in the mesh arenas
+        const size_t offset = (quantizedBuffer.data.size() + 3) & ~static_cast<size_t>(3);
+        quantizedBuffer.data.resize(offset + data.size());
+        std::memcpy(quantizedBuffer.data.data() + offset, data.data(), data.size());
+
+        tinygltf::BufferView bufferView;
+        bufferView.buffer = quantizedBufferIndex;
+        bufferView.byteOffset = offset;
+        bufferView.byteLength = data.size();
+        bufferView.byteStride = byteStride;
+        bufferView.target = TINYGLTF_TARGET_ARRAY_BUFFER;
+
+        stats.bytesBefore += accessor.count * componentCount * sizeof(float);
+        stats.bytesAfter += data.size();
+
+        // Bounds are optional for these attributes, and would now be in the quantized range
+        accessor.bufferView = static_cast<int>(model.bufferViews.size());
+        accessor.byteOffset = 0;
+        accessor.minValues.clear();
+        accessor.maxValues.clear();
+        model.bufferViews.push_back(std::move(bufferView));
+    }
+
+    if (!quantizedBuffer.data.empty())
+        model.buffers.push_back(std::move(quantizedBuffer));
+
+    return stats;
+}
@@ -0,0 +1,63 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MESHQUANTIZER_H
+#define MESHQUANTIZER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+#include "glm/glm.hpp"
+#include "tiny_gltf.h"
+
+struct MeshQuantizationStats
+{
+    size_t normals{0}; // Accessors quantized, per attribute
+    size_t texCoords{0};
+    size_t colors{0};
+    size_t bytesBefore{0}; // Of the quantized accessors
+    size_t bytesAfter{0};
+    float maxNormalError{0.0f}; // Largest angle between a decoded and a source normal, in degrees
+    float maxTexCoordError{0.0f};
+    float maxColorError{0.0f};
+};
+
+/**
+ * Rewrites the float vertex attributes of a glTF model in smaller formats before it is uploaded:
+ * - NORMAL: octahedral encoding in two snorm16, decoded by the HAS_OCTAHEDRAL_NORMALS shader variant
+ * - TEXCOORD_0: unorm16 when every coordinate is in [0, 1], else half floats
+ * - COLOR_0: unorm8
+ * Quantized accessors are moved to new bufferViews in a buffer appended to the model. Positions are left untouched,
+ * bounds, picking and LOD generation read them on the CPU
+ */
+class MeshQuantizer
+{
+public:
+    static constexpr int HalfFloatComponentType = GL_HALF_FLOAT; // Not a glTF component type, only set by Quantize
+    // Larger texcoords stay floats. Half floats step by 1/256 in [4, 8), so within it a texcoord is rounded by at
+    // most 1/512, and by 1/128 from 8 up
+    static constexpr float MaxHalfTexCoord = 8.0f;
+
+    static auto Quantize(tinygltf::Model& model) -> MeshQuantizationStats;
+
+    /**
+     * tinygltf::GetComponentSizeInBytes, with the half floats written by Quantize
+     */
+    static auto ComponentSize(int componentType) -> int;
+
+    /**
+     * Two snorm16 of the octahedral encoding of normal, the candidate of the grid nearest in angle
+     */
+    static auto EncodeOctahedral(const glm::vec3& normal) -> std::array<uint16_t, 2>;
+
+    /**
+     * Same decoding as default.vert, normalized
+     */
+    static auto DecodeOctahedral(const std::array<uint16_t, 2>& encoded) -> glm::vec3;
+};
+
+#endif //MESHQUANTIZER_H
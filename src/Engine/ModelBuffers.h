@@ -0,0 +1,49 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MODELBUFFERS_H
+#define MODELBUFFERS_H
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "Utility/MappedFile.h"
+
+/**
+ * Bytes of the buffers of a glTF model, read instead of tinygltf::Buffer::data. They are in the vectors of the model
+ * after an import, or in a mapping of the cooked file, see ModelCache, in which case the vectors are empty. Views
+ * over the vectors stay valid when the model is moved
+ */
+class ModelBuffers
+{
+private:
+    std::optional<MappedFile> m_mapping;
+    std::vector<std::span<const unsigned char>> m_buffers;
+
+public:
+    ModelBuffers() = default;
+
+    explicit ModelBuffers(const tinygltf::Model& model)
+    {
+        m_buffers.reserve(model.buffers.size());
+        for (const auto& buffer : model.buffers)
+            m_buffers.emplace_back(buffer.data);
+    }
+
+    ModelBuffers(MappedFile&& mapping, std::vector<std::span<const unsigned char>>&& buffers)
+        : m_mapping(std::move(mapping)), m_buffers(std::move(buffers))
+    {
+    }
+
+    [[nodiscard]] auto operator[](const size_t index) const -> std::span<const unsigned char>
+    {
+        return m_buffers[index];
+    }
+
+    [[nodiscard]] auto mappedBytes() const -> size_t { return m_mapping ? m_mapping->size() : 0; }
+};
+
+#endif //MODELBUFFERS_H
@@ -0,0 +1,334 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "ModelCache.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+#include "Utility/CacheFile.h"
+#include "Utility/Hash.h"
+
+namespace
+{
+    struct SourceFile
+    {
+        std::string path;
+        uint64_t size{0};
+        int64_t modificationTime{0}; // In ticks of the filesystem clock
+        uint64_t hash{0};
+    };
+
+    template <typename Archive>
+    auto serialize(Archive& archive, typename Archive::template Ref<SourceFile> source) -> void
+    {
+        archive(source.path, source.size, source.modificationTime, source.hash);
+    }
+}
+
+// Outside of the anonymous namespace, the archives find them by argument dependent lookup
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::BufferView> bufferView) -> void
+{
+    archive(bufferView.name, bufferView.buffer, bufferView.byteOffset, bufferView.byteLength,
+            bufferView.byteStride, bufferView.target);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Accessor> accessor) -> void
+{
+    archive(accessor.name, accessor.bufferView, accessor.byteOffset, accessor.normalized, accessor.componentType,
+            accessor.count, accessor.type, accessor.minValues, accessor.maxValues);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Primitive> primitive) -> void
+{
+    archive(primitive.attributes, primitive.targets, primitive.material, primitive.indices, primitive.mode);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Mesh> mesh) -> void
+{
+    archive(mesh.name, mesh.primitives, mesh.weights);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Node> node) -> void
+{
+    archive(node.name, node.camera, node.skin, node.mesh, node.children, node.rotation, node.scale,
+            node.translation, node.matrix, node.weights);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::AnimationChannel> channel) -> void
+{
+    archive(channel.sampler, channel.target_node, channel.target_path);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::AnimationSampler> sampler) -> void
+{
+    archive(sampler.input, sampler.output, sampler.interpolation);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Animation> animation) -> void
+{
+    archive(animation.name, animation.channels, animation.samplers);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::TextureInfo> info) -> void
+{
+    archive(info.index, info.texCoord);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::NormalTextureInfo> info) -> void
+{
+    archive(info.index, info.texCoord, info.scale);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::OcclusionTextureInfo> info) -> void
+{
+    archive(info.index, info.texCoord, info.strength);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::PbrMetallicRoughness> pbr) -> void
+{
+    archive(pbr.baseColorFactor, pbr.baseColorTexture, pbr.metallicFactor, pbr.roughnessFactor,
+            pbr.metallicRoughnessTexture);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Material> material) -> void
+{
+    archive(material.name, material.alphaMode, material.alphaCutoff, material.doubleSided,
+            material.pbrMetallicRoughness, material.normalTexture, material.occlusionTexture,
+            material.emissiveTexture, material.emissiveFactor);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Texture> texture) -> void
+{
+    archive(texture.name, texture.sampler, texture.source);
+}
+
+// Decoded pixels only, the image is never decoded again
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Image> image) -> void
+{
+    archive(image.name, image.width, image.height, image.component, image.bits, image.pixel_type, image.image);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Sampler> sampler) -> void
+{
+    archive(sampler.name, sampler.minFilter, sampler.magFilter, sampler.wrapS, sampler.wrapT);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Skin> skin) -> void
+{
+    archive(skin.name, skin.inverseBindMatrices, skin.skeleton, skin.joints);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Scene> scene) -> void
+{
+    archive(scene.name, scene.nodes);
+}
+
+// Only what the engine reads, cameras, lights and extensions are dropped. Buffers are blobs after the model
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<tinygltf::Model> model) -> void
+{
+    archive(model.bufferViews, model.accessors, model.meshes, model.nodes, model.animations,
+            model.skins, model.materials, model.textures, model.images, model.samplers, model.scenes,
+            model.defaultScene);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<PrimitiveLod> lod) -> void
+{
+    archive(lod.indexCount, lod.byteOffset, lod.firstIndex, lod.error);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<PrimitiveLods> lods) -> void
+{
+    archive(lods.mesh, lods.primitive, lods.levels);
+}
+
+template <typename Archive>
+static auto serialize(Archive& archive, typename Archive::template Ref<MeshLods> lods) -> void
+{
+    archive(lods.indices, lods.primitives);
+}
+
+namespace
+{
+    // Options changing what is cooked, merged buffers are built by Mesh::Create from the cooked model
+    auto optionBits(const MeshOptions& options) -> uint32_t
+    {
+        return static_cast<uint32_t>(options.generateLods) | static_cast<uint32_t>(options.optimizeIndices) << 1 |
+            static_cast<uint32_t>(options.quantizeAttributes) << 2;
+    }
+
+    auto statFile(const std::string& path, SourceFile& source) -> bool
+    {
+        std::error_code error;
+        source.size = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+
+        const auto modificationTime = std::filesystem::last_write_time(path, error);
+        source.modificationTime = modificationTime.time_since_epoch().count();
+        return !error;
+    }
+
+    auto hashFile(const std::string& path, uint64_t& hash) -> bool
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        std::array<char, 64 * 1024> block{};
+        hash = Fnv1aOffset;
+        while (file)
+        {
+            file.read(block.data(), block.size());
+            hash = fnv1a(reinterpret_cast<const unsigned char*>(block.data()), file.gcount(), hash);
+        }
+        return !file.bad();
+    }
+
+    auto isFresh(const SourceFile& source) -> bool
+    {
+        SourceFile current{.path = source.path};
+        if (!statFile(source.path, current) || current.size != source.size)
+            return false;
+        if (current.modificationTime == source.modificationTime)
+            return true;
+
+        // Touched or checked out again, the content decides
+        return hashFile(source.path, current.hash) && current.hash == source.hash;
+    }
+}
+
+auto ModelCache::Read(const std::string& cachePath, const MeshOptions& options, tinygltf::Model& model,
+                      MeshLods& lods, ModelBuffers& buffers, std::string& log) -> bool
+{
+    if (!std::filesystem::exists(cachePath))
+        return false;
+
+    auto e_mapping = MappedFile::Open(cachePath);
+    if (!e_mapping)
+    {
+        log += "[WARN] " + e_mapping.error() + "\n";
+        return false;
+    }
+
+    CacheReader reader(e_mapping->bytes());
+    if (!CacheFile::ReadHeader(reader, Magic, Version))
+        return false;
+
+    uint32_t bits = 0;
+    std::vector<SourceFile> sources;
+    reader(bits, sources);
+    if (reader.failed() || bits != optionBits(options) || !std::ranges::all_of(sources, isFresh))
+        return false;
+
+    tinygltf::Model cachedModel;
+    MeshLods cachedLods;
+    uint64_t bufferCount = 0;
+    reader(cachedModel, cachedLods, bufferCount);
+
+    std::vector<std::span<const unsigned char>> bufferBytes;
+    cachedModel.buffers.resize(reader.failed() ? 0 : bufferCount);
+    for (auto& buffer : cachedModel.buffers)
+    {
+        reader(buffer.name);
+        bufferBytes.push_back(reader.blob());
+    }
+    if (!reader.finished())
+        return false;
+
+    // Without mapped buffers, the mapping is released once the buffers are copied
+    if (options.mapBuffers)
+        buffers = ModelBuffers(*std::move(e_mapping), std::move(bufferBytes));
+    else
+    {
+        for (size_t i = 0; i < bufferBytes.size(); ++i)
+            cachedModel.buffers[i].data.assign(bufferBytes[i].begin(), bufferBytes[i].end());
+        buffers = ModelBuffers(cachedModel);
+    }
+
+    model = std::move(cachedModel);
+    lods = std::move(cachedLods);
+    return true;
+}
+
+auto ModelCache::Write(const std::string& cachePath, const std::string& sourcePath, const MeshOptions& options,
+                       const tinygltf::Model& model, const MeshLods& lods) -> bool
+{
+    // The engine ignores sparse data, the cooked model would not be the model the source describes
+    if (std::ranges::any_of(model.accessors, [](const auto& accessor) { return accessor.sparse.isSparse; }))
+        return false;
+
+    std::vector<SourceFile> sources;
+    const auto addSource = [&](const std::string& path) -> bool
+    {
+        if (std::ranges::find(sources, path, &SourceFile::path) != sources.end())
+            return true;
+
+        SourceFile source{.path = path};
+        if (!statFile(path, source) || !hashFile(path, source.hash))
+            return false;
+
+        sources.push_back(std::move(source));
+        return true;
+    };
+
+    // Data URIs are part of the .gltf, buffers without URI are the .glb binary chunk or added at import
+    const auto directory = std::filesystem::path(sourcePath).parent_path();
+    const auto addUri = [&](const std::string& uri) -> bool
+    {
+        if (uri.empty() || uri.starts_with("data:"))
+            return true;
+
+        // URIs are percent-encoded, tinygltf decodes them the same way before opening the files
+        std::string decoded;
+        if (!tinygltf::URIDecode(uri, &decoded, nullptr))
+            return false;
+        return addSource((directory / decoded).string());
+    };
+    if (!addSource(sourcePath))
+        return false;
+    for (const auto& buffer : model.buffers)
+    {
+        if (!addUri(buffer.uri))
+            return false;
+    }
+    for (const auto& image : model.images)
+    {
+        if (!addUri(image.uri))
+            return false;
+    }
+
+    return CacheFile::Write(cachePath, Magic, Version, [&](CacheWriter& writer)
+    {
+        writer(optionBits(options), sources, model, lods, static_cast<uint64_t>(model.buffers.size()));
+        for (const auto& buffer : model.buffers)
+        {
+            writer(buffer.name);
+            writer.blob(buffer.data);
+        }
+    });
+}
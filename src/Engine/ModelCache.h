@@ -0,0 +1,45 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "Mesh.h"
+#include "MeshOptions.h"
+#include "ModelBuffers.h"
+#include "tiny_gltf.h"
+
+/**
+ * Cooked binary form of an imported glTF model: the model as Mesh::Create reads it, after the optimizer and quantizer
+ * passes, with its images decoded and its LODs generated. Reading it skips JSON parsing, image decoding and every
+ * import pass. The cache is keyed by the import options and by the size, modification time and hash of the source
+ * files, the .gltf or .glb and the external buffers and images it references
+ */
+class ModelCache
+{
+private:
+    static constexpr uint32_t Magic = 0x434C4748; // "HGLC"
+    static constexpr uint32_t Version = 2;
+
+public:
+    /**
+     * False when the cache is missing, stale, for other options or from another version. The file is read through a
+     * mapping, with MeshOptions::mapBuffers the model buffers stay in it and their vectors are left empty. Warnings
+     * are appended to log, it can run on a worker
+     */
+    static auto Read(const std::string& cachePath, const MeshOptions& options, tinygltf::Model& model,
+                     MeshLods& lods, ModelBuffers& buffers, std::string& log) -> bool;
+
+    /**
+     * False when a source file can't be read back or the cache can't be written, models with sparse accessors are
+     * never cooked
+     */
+    static auto Write(const std::string& cachePath, const std::string& sourcePath, const MeshOptions& options,
+                      const tinygltf::Model& model, const MeshLods& lods) -> bool;
+};
+
+#endif //MODELCACHE_H
@@ -0,0 +1,62 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MODELLOAD_H
+#define MODELLOAD_H
+
+#include <chrono>
+#include <future>
+#include <string>
+
+#include "Expected.h"
+#include "Mesh.h"
+#include "MeshOptions.h"
+#include "ModelBuffers.h"
+#include "tiny_gltf.h"
+
+/**
+ * CPU side of a model load, parsed or read from the cooked cache with the import passes done. Only the GL uploads of
+ * Mesh::Create are left
+ */
+struct PreparedModel
+{
+    tinygltf::Model model;
+    ModelBuffers buffers;
+    MeshLods lods;
+    bool cooked{false}; // Read from the cooked cache
+    float prepareTime{0.0f}; // In milliseconds
+    std::string log; // Printed by the context thread, so the lines of concurrent loads don't interleave
+};
+
+/**
+ * Model being prepared on the engine workers by Engine::loadModelAsync, Engine::finishModelLoad uploads it on the
+ * context thread
+ */
+class ModelLoad
+{
+private:
+    friend class Engine;
+
+    std::string m_id;
+    MeshOptions m_options;
+    std::future<Expected<PreparedModel, std::string>> m_prepared;
+
+    ModelLoad(std::string&& id, const MeshOptions& options, std::future<Expected<PreparedModel, std::string>>&& prepared)
+        : m_id(std::move(id)), m_options(options), m_prepared(std::move(prepared))
+    {
+    }
+
+public:
+    /**
+     * True once finishing the load only leaves the GL uploads, it no longer waits for the workers
+     */
+    [[nodiscard]] auto ready() const -> bool
+    {
+        return m_prepared.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    [[nodiscard]] auto id() const -> const std::string& { return m_id; }
+};
+
+#endif //MODELLOAD_H
@@ -7,6 +7,8 @@
 #include <memory>
 #include <unordered_set>
 
+#include "Bounds.h"
+#include "Bvh.h"
 #include "EngineComponent.h"
 #include "Mesh.h"
 #include "Transform.h"
@@ -20,6 +22,8 @@ class Object
 private:
     Transform m_transform{};
     std::unordered_set<std::unique_ptr<EngineComponent>> m_components;
+    AABB m_worldBounds{}; // Empty when the object renders nothing or can't be culled
+    Bvh::ProxyId m_bvhProxy{Bvh::NullProxy};
 
     auto willUpdate(Engine& engine) const -> void
     {
@@ -33,6 +37,15 @@ private:
             component->onUpdate(engine);
     }
 
+    auto updateBounds(Engine& engine) -> void
+    {
+        AABB bounds;
+        bool bounded = true;
+        for (auto& component : m_components)
+            bounded &= component->onUpdateBounds(engine, bounds);
+        m_worldBounds = bounded ? bounds : AABB{};
+    }
+
     auto render(Engine& engine) const -> void
     {
         for (auto& component : m_components)
@@ -49,6 +62,8 @@ public:
     [[nodiscard]] auto transform() -> Transform& { return m_transform; }
     [[nodiscard]] auto transform() const -> const Transform& { return m_transform; }
 
+    [[nodiscard]] auto worldBounds() const -> const AABB& { return m_worldBounds; }
+
     template <class T, class... Args>
         requires std::derived_from<T, EngineComponent> && std::constructible_from<T, Object&, Args...>
     auto addComponent(Args&&... args) -> T&
@@ -0,0 +1,157 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include <iterator>
+
+#include "OcclusionCuller.h"
+#include "Engine.h"
+
+namespace
+{
+    // Boxes are slightly enlarged so faces lying on their own geometry pass the depth test
+    constexpr float BoundsMargin = 0.01f;
+
+    constexpr GLubyte CubeIndices[] = {
+        0, 1, 3, 0, 3, 2, // -X
+        4, 6, 7, 4, 7, 5, // +X
+        0, 4, 5, 0, 5, 1, // -Y
+        2, 3, 7, 2, 7, 6, // +Y
+        0, 2, 6, 0, 6, 4, // -Z
+        1, 5, 7, 1, 7, 3, // +Z
+    };
+}
+
+auto OcclusionCuller::Create(const std::string& vertPath, const std::string& fragPath)
+    -> Expected<OcclusionCuller, std::string>
+{
+    auto e_program = ShaderProgram::Create(vertPath, fragPath);
+    if (!e_program)
+        return Unexpected(std::move(e_program).error());
+
+    auto e_instance = e_program->enableVariant(ShaderHasNone);
+    if (!e_instance)
+        return Unexpected(std::move(e_instance).error());
+
+    float cubeVertices[8 * 3];
+    for (int i = 0; i < 8; ++i)
+    {
+        cubeVertices[i * 3 + 0] = static_cast<float>((i >> 2) & 1);
+        cubeVertices[i * 3 + 1] = static_cast<float>((i >> 1) & 1);
+        cubeVertices[i * 3 + 2] = static_cast<float>(i & 1);
+    }
+
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+
+    auto vertexArray = VertexArray::Create(VertexArrayHasPosition);
+    VertexArray::bindArrayBuffer(buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    vertexArray.bindElementArrayBuffer(buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(CubeIndices), CubeIndices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    return OcclusionCuller(*std::move(e_program), std::move(vertexArray), buffers[0], buffers[1]);
+}
+
+OcclusionCuller::OcclusionCuller(ShaderProgram&& program, VertexArray&& cubeVertexArray,
+                                 const GLuint cubeVertexBuffer, const GLuint cubeIndexBuffer)
+    : m_program(std::move(program)), m_cubeVertexArray(std::move(cubeVertexArray)),
+      m_cubeVertexBuffer(cubeVertexBuffer), m_cubeIndexBuffer(cubeIndexBuffer)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    for (const auto& query : m_queries)
+        glDeleteQueries(1, &query.id);
+    glDeleteBuffers(1, &m_cubeVertexBuffer);
+    glDeleteBuffers(1, &m_cubeIndexBuffer);
+}
+
+auto OcclusionCuller::setEnabled(const bool enabled) -> void
+{
+    if (enabled && !m_enabled)
+    {
+        for (auto& query : m_queries)
+            query.occluded = false;
+    }
+    m_enabled = enabled;
+}
+
+auto OcclusionCuller::createQuery() -> QueryId
+{
+    Query query;
+    glGenQueries(1, &query.id);
+    m_queries.push_back(query);
+    return static_cast<QueryId>(m_queries.size() - 1);
+}
+
+auto OcclusionCuller::isVisible(const QueryId queryId, const AABB& bounds, const glm::vec3& cameraPosition) -> bool
+{
+    if (!m_enabled || bounds.empty())
+        return true;
+
+    Query& query = m_queries[queryId];
+    if (query.pending)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            return !query.occluded;
+
+        GLuint samplesPassed = GL_FALSE;
+        glGetQueryObjectuiv(query.id, GL_QUERY_RESULT, &samplesPassed);
+        query.occluded = samplesPassed == GL_FALSE;
+        query.pending = false;
+    }
+
+    const glm::vec3 margin = bounds.extent() * BoundsMargin + glm::vec3(BoundsMargin);
+    query.bounds = {.min = bounds.min - margin, .max = bounds.max + margin};
+
+    if (query.bounds.contains(cameraPosition))
+    {
+        query.occluded = false;
+        return true;
+    }
+
+    m_scheduledQueries.push_back(queryId);
+    return !query.occluded;
+}
+
+auto OcclusionCuller::issueQueries(Engine& engine) -> void
+{
+    if (m_scheduledQueries.empty())
+        return;
+
+    auto& program = m_program.getProgram(ShaderHasNone);
+    engine.useProgram(program);
+    engine.bindVertexArray(m_cubeVertexArray);
+    engine.setPolygoneMode(GL_FILL);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    if (!engine.isDoubleSided())
+        glDisable(GL_CULL_FACE); // Back faces still count when the front ones are clipped
+
+    for (const QueryId queryId : m_scheduledQueries)
+    {
+        Query& query = m_queries[queryId];
+        program.setVec3(UniformId::BoundsMin, query.bounds.min);
+        program.setVec3(UniformId::BoundsMax, query.bounds.max);
+
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, query.id);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(std::size(CubeIndices)), GL_UNSIGNED_BYTE, nullptr);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        query.pending = true;
+    }
+    m_scheduledQueries.clear();
+
+    if (!engine.isDoubleSided())
+        glEnable(GL_CULL_FACE);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
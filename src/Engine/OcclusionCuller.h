@@ -0,0 +1,95 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Bounds.h"
+#include "Expected.h"
+#include "glad/gl.h"
+#include "OpenGL/ShaderProgram.h"
+#include "OpenGL/VertexArray.h"
+
+class Engine;
+
+/**
+ * Occlusion culling with GL_ANY_SAMPLES_PASSED queries on bounding boxes, drawn against the depth buffer once the
+ * frame is rendered. A box is only culled from the result of a previous frame that is already available, so reading
+ * a query never stalls, and it is queried again as soon as that result is known
+ */
+class OcclusionCuller
+{
+public:
+    using QueryId = int32_t;
+
+private:
+    struct Query
+    {
+        GLuint id{0};
+        AABB bounds;
+        bool pending{false}; // Issued, result not read yet
+        bool occluded{false}; // Last result read
+    };
+
+    ShaderProgram m_program;
+    VertexArray m_cubeVertexArray;
+    GLuint m_cubeVertexBuffer{0};
+    GLuint m_cubeIndexBuffer{0};
+
+    std::vector<Query> m_queries;
+    std::vector<QueryId> m_scheduledQueries; // To issue at the end of the frame
+    bool m_enabled{true};
+
+public:
+    static auto Create(const std::string& vertPath, const std::string& fragPath)
+        -> Expected<OcclusionCuller, std::string>;
+
+    OcclusionCuller(ShaderProgram&& program, VertexArray&& cubeVertexArray, GLuint cubeVertexBuffer,
+                    GLuint cubeIndexBuffer);
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+
+    OcclusionCuller(OcclusionCuller&& other) noexcept
+        : m_program(std::move(other.m_program)),
+          m_cubeVertexArray(std::move(other.m_cubeVertexArray)),
+          m_cubeVertexBuffer(std::exchange(other.m_cubeVertexBuffer, 0)),
+          m_cubeIndexBuffer(std::exchange(other.m_cubeIndexBuffer, 0)),
+          m_queries(std::move(other.m_queries)),
+          m_scheduledQueries(std::move(other.m_scheduledQueries)),
+          m_enabled(other.m_enabled)
+    {
+    }
+
+    ~OcclusionCuller();
+
+    auto operator=(const OcclusionCuller&) -> OcclusionCuller& = delete;
+    auto operator=(OcclusionCuller&&) -> OcclusionCuller& = delete;
+
+    [[nodiscard]] auto enabled() const -> bool { return m_enabled; }
+
+    /**
+     * Disabled, every box is visible and no query is issued. Results are forgotten when enabled again
+     */
+    auto setEnabled(bool enabled) -> void;
+
+    auto createQuery() -> QueryId;
+
+    /**
+     * Last known visibility of the box, also schedules a new query of bounds when the previous one is done.
+     * A box containing the camera is always visible since its faces may be clipped by the near plane
+     */
+    [[nodiscard]] auto isVisible(QueryId query, const AABB& bounds, const glm::vec3& cameraPosition) -> bool;
+
+    /**
+     * Draws the boxes scheduled during the render phase, must be called after the render queue flush
+     */
+    auto issueQueries(Engine& engine) -> void;
+};
+
+#endif //OCCLUSIONCULLER_H
@@ -0,0 +1,56 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef POSE_H
+#define POSE_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "Utility/DynamicBitset.h"
+
+/**
+ * Local TRS of every node of a mesh, stored as structure of arrays and indexed by glTF node index.
+ * The `animated` bitmask flags the nodes written by the current animation.
+ */
+struct Pose
+{
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    DynamicBitset animated;
+
+    [[nodiscard]] auto size() const -> size_t { return translations.size(); }
+
+    auto resize(const size_t count) -> void
+    {
+        translations.resize(count, glm::vec3(0.0f));
+        rotations.resize(count, glm::identity<glm::quat>());
+        scales.resize(count, glm::vec3(1.0f));
+        animated.resize(count);
+    }
+
+    [[nodiscard]] auto isAnimated(const size_t node) const -> bool { return animated.test(node); }
+
+    auto setAnimated(const size_t node) -> void { animated.set(node); }
+
+    [[nodiscard]] auto localMatrix(const size_t node) const -> glm::mat4
+    {
+        return localMatrix(node, scales[node]);
+    }
+
+    // T * R * S, built directly instead of through glm::translate and glm::scale
+    [[nodiscard]] auto localMatrix(const size_t node, const glm::vec3 scale) const -> glm::mat4
+    {
+        glm::mat4 matrix = glm::mat4_cast(rotations[node]);
+        matrix[0] *= scale.x;
+        matrix[1] *= scale.y;
+        matrix[2] *= scale.z;
+        matrix[3] = glm::vec4(translations[node], 1.0f);
+        return matrix;
+    }
+};
+
+#endif //POSE_H
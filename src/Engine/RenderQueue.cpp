@@ -0,0 +1,353 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+#include "DrawUniforms.h"
+#include "Engine.h"
+#include "Mesh.h"
+#include "OpenGL/Extensions.h"
+#include "glm/gtc/type_ptr.hpp"
+
+static void* bufferOffset(const size_t offset)
+{
+    return reinterpret_cast<void*>(offset);
+}
+
+// Items of the same multi draw only differ by their primitive, which is last in the sort key
+static auto multiDrawKey(const RenderQueue::DrawItem& item)
+{
+    return std::make_tuple(item.polygonMode, item.program->id(), item.vertexArray->id(), item.baseColorTexture,
+                           item.mesh, item.material, item.mode);
+}
+
+static auto sortKey(const RenderQueue::DrawItem& item)
+{
+    return std::tuple_cat(multiDrawKey(item), std::make_tuple(item.meshIndex, item.primitiveIndex, item.lod));
+}
+
+auto RenderQueue::push(const Mesh& mesh, const int meshIndex, const int primitiveIndex, const int lod,
+                       ShaderProgramInstance& program, const GLenum polygonMode, const DrawMode mode,
+                       const glm::mat4& transform) -> void
+{
+    const auto& primitive = mesh.model().meshes[meshIndex].primitives[primitiveIndex];
+    const auto& primitiveRenderInfo = mesh.renderInfo().meshes[meshIndex].primitives[primitiveIndex];
+
+    GLuint baseColorTexture = 0;
+    if (primitive.material >= 0)
+    {
+        const auto& material = mesh.model().materials[primitive.material];
+        if (material.pbrMetallicRoughness.baseColorTexture.index >= 0)
+            baseColorTexture = mesh.texture(material.pbrMetallicRoughness.baseColorTexture.index);
+    }
+
+    const VertexArray* vertexArray = &primitiveRenderInfo.vertexArray;
+    if (mode == DrawMode::Instanced)
+        vertexArray = &primitiveRenderInfo.instancedVertexArray;
+    else if (mode == DrawMode::MultiDraw)
+        vertexArray = &mesh.renderInfo().mergedGroups[primitiveRenderInfo.mergedGroup].vertexArray;
+
+    m_items.push_back({
+        .polygonMode = polygonMode,
+        .program = &program,
+        .vertexArray = vertexArray,
+        .baseColorTexture = baseColorTexture,
+        .mesh = &mesh,
+        .material = primitive.material,
+        .mode = mode,
+        .meshIndex = meshIndex,
+        .primitiveIndex = primitiveIndex,
+        .lod = std::min(lod, static_cast<int>(primitiveRenderInfo.lods.size())),
+        .transformIndex = static_cast<uint32_t>(m_transforms.size()),
+    });
+    m_transforms.push_back(transform);
+}
+
+auto RenderQueue::buildRuns() -> void
+{
+    std::ranges::sort(m_items, [](const DrawItem& a, const DrawItem& b) { return sortKey(a) < sortKey(b); });
+
+    // Items that can be merged are now contiguous, each group becomes one draw call
+    m_runs.clear();
+    m_commands.clear();
+    m_instanceCount = 0;
+    for (size_t begin = 0; begin < m_items.size();)
+    {
+        const DrawItem& first = m_items[begin];
+
+        size_t end = begin + 1;
+        if (first.mode == DrawMode::Instanced)
+        {
+            while (end < m_items.size() && sortKey(m_items[end]) == sortKey(first))
+                ++end;
+        }
+        else if (first.mode == DrawMode::MultiDraw)
+        {
+            while (end < m_items.size() && multiDrawKey(m_items[end]) == multiDrawKey(first))
+                ++end;
+        }
+
+        DrawRun run{.begin = begin, .end = end};
+        if (first.mode != DrawMode::Single)
+            m_instanceCount += end - begin;
+        if (first.mode == DrawMode::MultiDraw)
+            buildCommands(run);
+
+        m_runs.push_back(run);
+        begin = end;
+    }
+}
+
+auto RenderQueue::buildCommands(DrawRun& run) -> void
+{
+    run.firstCommand = m_commands.size();
+
+    // Identical primitives are contiguous too, each one is a single instanced command
+    GLuint instance = 0;
+    for (size_t begin = run.begin; begin < run.end;)
+    {
+        const DrawItem& item = m_items[begin];
+        const auto& primitiveRenderInfo = item.mesh->renderInfo().meshes[item.meshIndex].primitives[item.primitiveIndex];
+
+        size_t end = begin + 1;
+        while (end < run.end && m_items[end].meshIndex == item.meshIndex &&
+            m_items[end].primitiveIndex == item.primitiveIndex && m_items[end].lod == item.lod)
+            ++end;
+
+        const auto instanceCount = static_cast<GLuint>(end - begin);
+        GLuint count = primitiveRenderInfo.indexCount;
+        GLuint firstIndex = primitiveRenderInfo.firstIndex;
+        if (item.lod > 0)
+        {
+            count = static_cast<GLuint>(primitiveRenderInfo.lods[item.lod - 1].indexCount);
+            firstIndex = primitiveRenderInfo.lods[item.lod - 1].firstIndex;
+        }
+
+        m_commands.push_back({
+            .count = count,
+            .instanceCount = instanceCount,
+            .firstIndex = firstIndex,
+            .baseVertex = primitiveRenderInfo.baseVertex,
+            .baseInstance = instance,
+        });
+
+        instance += instanceCount;
+        begin = end;
+    }
+
+    run.commandCount = m_commands.size() - run.firstCommand;
+}
+
+auto RenderQueue::writeRuns() -> void
+{
+    if (m_uniformRing.id() == 0)
+    {
+        GLint uniformAlignment;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+        m_uniformRing = RingBuffer::Create(64 * 1024, uniformAlignment);
+        m_instanceRing = RingBuffer::Create(64 * 1024, sizeof(glm::vec4));
+        m_commandRing = RingBuffer::Create(16 * 1024, sizeof(GLuint));
+    }
+
+    m_uniformRing.beginFrame(static_cast<GLsizeiptr>(m_runs.size()) * m_uniformRing.alignedSize(sizeof(DrawUniforms)));
+    m_instanceRing.beginFrame(static_cast<GLsizeiptr>(m_instanceCount * sizeof(glm::mat4)));
+    if (Extensions::hasMultiDrawIndirect())
+        m_commandRing.beginFrame(static_cast<GLsizeiptr>(m_commands.size() * sizeof(DrawElementsIndirectCommand)));
+
+    for (auto& run : m_runs)
+    {
+        const DrawItem& item = m_items[run.begin];
+
+        DrawUniforms uniforms;
+        if (item.mode == DrawMode::Single)
+            uniforms.transform = m_transforms[item.transformIndex];
+        if (item.material >= 0)
+        {
+            const auto& material = item.mesh->model().materials[item.material];
+            uniforms.baseColorFactor = glm::make_vec4(material.pbrMetallicRoughness.baseColorFactor.data());
+            uniforms.normalScale = static_cast<float>(material.normalTexture.scale);
+        }
+
+        const auto uniformsAllocation = m_uniformRing.allocate(sizeof(DrawUniforms));
+        std::memcpy(uniformsAllocation.data, &uniforms, sizeof(DrawUniforms));
+        run.uniformsOffset = uniformsAllocation.offset;
+
+        if (item.mode != DrawMode::Single)
+        {
+            const auto count = run.end - run.begin;
+            const auto instanceAllocation = m_instanceRing.allocate(
+                static_cast<GLsizeiptr>(count * sizeof(glm::mat4)));
+
+            auto* instances = static_cast<glm::mat4*>(instanceAllocation.data);
+            for (size_t i = 0; i < count; ++i)
+                instances[i] = m_transforms[m_items[run.begin + i].transformIndex];
+            run.instanceOffset = instanceAllocation.offset;
+        }
+
+        if (item.mode == DrawMode::MultiDraw && Extensions::hasMultiDrawIndirect())
+        {
+            const auto size = run.commandCount * sizeof(DrawElementsIndirectCommand);
+            const auto commandsAllocation = m_commandRing.allocate(static_cast<GLsizeiptr>(size));
+            std::memcpy(commandsAllocation.data, m_commands.data() + run.firstCommand, size);
+            run.commandsOffset = commandsAllocation.offset;
+        }
+    }
+
+    m_uniformRing.flushWrites();
+    m_instanceRing.flushWrites();
+    if (Extensions::hasMultiDrawIndirect())
+        m_commandRing.flushWrites();
+}
+
+auto RenderQueue::submitRun(Engine& engine, const DrawRun& run, const DrawItem* previous) -> void
+{
+    const DrawItem& item = m_items[run.begin];
+
+    engine.setPolygoneMode(item.polygonMode);
+    engine.useProgram(*item.program);
+    engine.bindVertexArray(*item.vertexArray);
+
+    // Sampler uniforms are program state, they are still valid when the previous run used the same material
+    const bool sameMaterial = previous != nullptr && previous->program == item.program &&
+        previous->mesh == item.mesh && previous->material == item.material;
+    if (!sameMaterial)
+        bindMaterial(engine, *item.mesh, item.material, *item.program);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBlockId::Draw), m_uniformRing.id(),
+                      run.uniformsOffset, sizeof(DrawUniforms));
+
+    if (item.mode == DrawMode::MultiDraw)
+    {
+        submitMultiDraw(run);
+        return;
+    }
+
+    if (item.mode == DrawMode::Instanced)
+    {
+        VertexArray::bindArrayBuffer(m_instanceRing.id());
+        bindInstanceTransforms(run.instanceOffset);
+    }
+
+    drawPrimitive(*item.mesh, item.meshIndex, item.primitiveIndex, item.lod,
+                  static_cast<GLsizei>(run.end - run.begin));
+}
+
+auto RenderQueue::submitMultiDraw(const DrawRun& run) -> void
+{
+    const DrawItem& item = m_items[run.begin];
+    const auto& primitiveRenderInfo = item.mesh->renderInfo().meshes[item.meshIndex].primitives[item.primitiveIndex];
+    const auto& mergedGroup = item.mesh->renderInfo().mergedGroups[primitiveRenderInfo.mergedGroup];
+
+    VertexArray::bindArrayBuffer(m_instanceRing.id());
+
+    if (Extensions::hasMultiDrawIndirect())
+    {
+        bindInstanceTransforms(run.instanceOffset);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandRing.id());
+        Extensions::multiDrawElementsIndirect(mergedGroup.mode, GL_UNSIGNED_INT, bufferOffset(run.commandsOffset),
+                                              static_cast<GLsizei>(run.commandCount), 0);
+        return;
+    }
+
+    // Without base instance support, each command points the instance attribute to its first transform
+    for (size_t i = run.firstCommand; i < run.firstCommand + run.commandCount; ++i)
+    {
+        const auto& command = m_commands[i];
+        bindInstanceTransforms(run.instanceOffset + static_cast<GLintptr>(command.baseInstance * sizeof(glm::mat4)));
+        glDrawElementsInstancedBaseVertex(mergedGroup.mode, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+                                          bufferOffset(command.firstIndex * sizeof(GLuint)),
+                                          static_cast<GLsizei>(command.instanceCount), command.baseVertex);
+    }
+}
+
+auto RenderQueue::bindInstanceTransforms(const GLintptr offset) -> void
+{
+    // A mat4 attribute takes four consecutive locations, one per column
+    for (int column = 0; column < 4; ++column)
+    {
+        glVertexAttribPointer(VertexArray::InstanceTransformLocation + column, 4, GL_FLOAT, GL_FALSE,
+                              sizeof(glm::mat4), bufferOffset(offset + (column * sizeof(glm::vec4))));
+    }
+}
+
+auto RenderQueue::flush(Engine& engine) -> void
+{
+    buildRuns();
+    writeRuns();
+
+    const DrawItem* previous = nullptr;
+    for (const auto& run : m_runs)
+    {
+        submitRun(engine, run, previous);
+        previous = &m_items[run.begin];
+    }
+
+    m_uniformRing.endFrame();
+    m_instanceRing.endFrame();
+    if (Extensions::hasMultiDrawIndirect())
+        m_commandRing.endFrame();
+
+    // Keep the capacity for next frame
+    m_items.clear();
+    m_transforms.clear();
+}
+
+auto RenderQueue::bindMaterial(Engine& engine, const Mesh& mesh, const int material,
+                               ShaderProgramInstance& program) -> void
+{
+    if (material >= 0)
+    {
+        const auto& gltfMaterial = mesh.model().materials[material];
+
+        engine.setDoubleSided(gltfMaterial.doubleSided);
+
+        if (gltfMaterial.pbrMetallicRoughness.baseColorTexture.index >= 0)
+        {
+            engine.bindTexture(0, mesh.texture(gltfMaterial.pbrMetallicRoughness.baseColorTexture.index));
+            program.setInt(UniformId::BaseColorTexture, 0);
+        }
+
+        if (gltfMaterial.normalTexture.index >= 0)
+        {
+            engine.bindTexture(1, mesh.texture(gltfMaterial.normalTexture.index));
+            program.setInt(UniformId::NormalMap, 1);
+        }
+    }
+    else
+    {
+        engine.setDoubleSided(false);
+    }
+}
+
+auto RenderQueue::drawPrimitive(const Mesh& mesh, const int meshIndex, const int primitiveIndex, const int lod,
+                                const GLsizei instanceCount) -> void
+{
+    const auto& primitive = mesh.model().meshes[meshIndex].primitives[primitiveIndex];
+
+    assert(primitive.indices >= 0); // TODO handle non indexed primitives
+
+    const tinygltf::Accessor& indexAccessor = mesh.model().accessors[primitive.indices];
+    auto indexCount = static_cast<GLsizei>(indexAccessor.count);
+    GLenum indexType = indexAccessor.componentType;
+    auto indexOffset = static_cast<size_t>(mesh.renderInfo().accessors[primitive.indices].byteOffset);
+
+    // Simplified levels live in the same index arena, so the vertex array bound for the primitive still applies
+    if (lod > 0)
+    {
+        const auto& primitiveLod = mesh.renderInfo().meshes[meshIndex].primitives[primitiveIndex].lods[lod - 1];
+        indexCount = primitiveLod.indexCount;
+        indexType = GL_UNSIGNED_INT;
+        indexOffset = static_cast<size_t>(primitiveLod.byteOffset);
+    }
+
+    if (instanceCount == 1)
+        glDrawElements(primitive.mode, indexCount, indexType, bufferOffset(indexOffset));
+    else
+        glDrawElementsInstanced(primitive.mode, indexCount, indexType, bufferOffset(indexOffset), instanceCount);
+}
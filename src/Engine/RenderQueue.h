@@ -0,0 +1,122 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "OpenGL/RingBuffer.h"
+#include "OpenGL/ShaderProgram.h"
+#include "OpenGL/VertexArray.h"
+
+class Engine;
+class Mesh;
+
+/**
+ * Collects the primitives of every MeshRenderer during the render phase, sorts them by GPU state, then submits them,
+ * so program, vertex array and texture switches scale with the number of unique states instead of the number of
+ * objects. Consecutive instanced items of the same primitive are drawn with a single glDrawElementsInstanced, and
+ * consecutive items of merged meshes sharing a program and material with a single glMultiDrawElementsIndirect.
+ * Per-draw uniforms, instance matrices and indirect commands are streamed through ring buffers.
+ */
+class RenderQueue
+{
+public:
+    enum class DrawMode : unsigned char
+    {
+        Single,
+        Instanced, // Merged with the identical items of other renderers
+        MultiDraw, // Merged with the items of the same merged group and material, primitive needs a mergedGroup
+    };
+
+    struct DrawItem
+    {
+        // Sort key, grouping items by state, the first fields change the least often
+        GLenum polygonMode;
+        ShaderProgramInstance* program;
+        const VertexArray* vertexArray;
+        GLuint baseColorTexture;
+        const Mesh* mesh;
+        int material;
+        DrawMode mode;
+        int meshIndex;
+        int primitiveIndex;
+        int lod; // 0 for the original primitive, else its level in PrimitiveRenderInfo::lods + 1
+
+        uint32_t transformIndex;
+    };
+
+private:
+    // Consecutive items drawn by a single draw call
+    struct DrawRun
+    {
+        size_t begin;
+        size_t end;
+        GLintptr instanceOffset; // In m_instanceRing, instanced and multi draw runs only
+        GLintptr uniformsOffset; // In m_uniformRing
+        size_t firstCommand; // In m_commands, multi draw runs only
+        size_t commandCount;
+        GLintptr commandsOffset; // In m_commandRing
+    };
+
+    // Layout fixed by glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    std::vector<DrawItem> m_items;
+    std::vector<DrawRun> m_runs;
+    std::vector<glm::mat4> m_transforms;
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    size_t m_instanceCount{0};
+
+    // Created on first flush, the queue is constructed before the OpenGL loader
+    RingBuffer m_instanceRing;
+    RingBuffer m_uniformRing;
+    RingBuffer m_commandRing;
+
+    auto buildRuns() -> void;
+    auto buildCommands(DrawRun& run) -> void;
+    auto writeRuns() -> void;
+    auto submitRun(Engine& engine, const DrawRun& run, const DrawItem* previous) -> void;
+    auto submitMultiDraw(const DrawRun& run) -> void;
+
+    static auto bindInstanceTransforms(GLintptr offset) -> void;
+
+public:
+    /**
+     * Queue a primitive, program must be the variant matching its shader flags, with ShaderHasInstanceTransforms
+     * unless mode is Single. lod is clamped to the levels of the primitive
+     */
+    auto push(const Mesh& mesh, int meshIndex, int primitiveIndex, int lod, ShaderProgramInstance& program,
+              GLenum polygonMode, DrawMode mode, const glm::mat4& transform) -> void;
+
+    /**
+     * Sort, draw and clear every queued item
+     */
+    auto flush(Engine& engine) -> void;
+
+    [[nodiscard]] auto size() const noexcept -> size_t { return m_items.size(); }
+
+    /**
+     * Bind the textures of a material, its factors are per-draw uniforms
+     */
+    static auto bindMaterial(Engine& engine, const Mesh& mesh, int material, ShaderProgramInstance& program) -> void;
+
+    /**
+     * Issue the indexed draw of a primitive, once its vertex array and material are bound
+     */
+    static auto drawPrimitive(const Mesh& mesh, int meshIndex, int primitiveIndex, int lod,
+                              GLsizei instanceCount) -> void;
+};
+
+#endif //RENDERQUEUE_H
@@ -0,0 +1,26 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Counters of the render phase, reset at its start, so they describe the previous frame during the update phase
+ */
+struct RenderStats
+{
+    uint32_t visibleObjects{0};
+    uint32_t culledObjects{0}; // Skipped by the engine BVH query
+    uint32_t visibleNodes{0};
+    uint32_t culledNodes{0}; // Outside of the camera frustum
+    uint32_t occludedNodes{0}; // Hidden during the previous frames
+    std::array<uint32_t, 4> lodNodes{}; // Visible nodes per selected level of detail
+    uint32_t uploadedTextureBytes{0}; // Streamed before the draws, see TextureUploadQueue
+    uint32_t pendingTextures{0}; // Drawn with the placeholder
+};
+
+#endif //RENDERSTATS_H
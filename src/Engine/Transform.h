@@ -13,6 +13,8 @@ struct Transform
     glm::quat rotation = glm::identity<glm::quat>();
     glm::vec3 scale{1.0f};
 
+    auto operator==(const Transform& other) const -> bool = default;
+
     [[nodiscard]] auto trs() const -> glm::mat4
     {
         auto mat = glm::identity<glm::mat4>();
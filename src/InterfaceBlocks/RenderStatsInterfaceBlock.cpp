@@ -0,0 +1,34 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "RenderStatsInterfaceBlock.h"
+
+RenderStatsInterfaceBlock::RenderStatsInterfaceBlock(UserInterface& interface)
+{
+}
+
+auto RenderStatsInterfaceBlock::onDrawUI(uint16_t blockId, Engine& engine, UserInterface& interface) -> void
+{
+    const auto& stats = engine.renderStats();
+
+    ImGui::Text("Rendering");
+    ImGui::Text("Visible objects: %u", stats.visibleObjects);
+    ImGui::Text("Culled objects: %u", stats.culledObjects);
+    ImGui::Text("Visible nodes: %u", stats.visibleNodes);
+    ImGui::Text("Culled nodes: %u", stats.culledNodes);
+    ImGui::Text("LODs: %u / %u / %u / %u", stats.lodNodes[0], stats.lodNodes[1], stats.lodNodes[2],
+                stats.lodNodes[3]);
+    if (stats.pendingTextures > 0 || stats.uploadedTextureBytes > 0)
+        ImGui::Text("Streaming textures: %u pending, %u KiB this frame", stats.pendingTextures,
+                    stats.uploadedTextureBytes / 1024);
+
+    if (auto occlusionCuller = engine.occlusionCuller())
+    {
+        ImGui::Text("Occluded nodes: %u", stats.occludedNodes);
+
+        bool enabled = occlusionCuller->get().enabled();
+        if (ImGui::Checkbox("Occlusion culling", &enabled))
+            occlusionCuller->get().setEnabled(enabled);
+    }
+}
@@ -0,0 +1,17 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef RENDERSTATSINTERFACEBLOCK_H
+#define RENDERSTATSINTERFACEBLOCK_H
+#include "Components/UserInterface.h"
+
+class RenderStatsInterfaceBlock : public InterfaceBlock
+{
+public:
+    explicit RenderStatsInterfaceBlock(UserInterface& interface);
+
+    auto onDrawUI(uint16_t blockId, Engine& engine, UserInterface& interface) -> void override;
+};
+
+#endif //RENDERSTATSINTERFACEBLOCK_H
@@ -0,0 +1,26 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "Extensions.h"
+
+#include "GLFW/glfw3.h"
+
+template <typename Proc>
+static auto loadProc(const char* extension, const char* name) -> Proc
+{
+    if (!glfwExtensionSupported(extension))
+        return nullptr;
+    return reinterpret_cast<Proc>(glfwGetProcAddress(name));
+}
+
+auto Extensions::load() -> void
+{
+    bufferStorage = loadProc<BufferStorageProc>("GL_ARB_buffer_storage", "glBufferStorage");
+
+    if (glfwExtensionSupported("GL_ARB_base_instance"))
+    {
+        multiDrawElementsIndirect = loadProc<MultiDrawElementsIndirectProc>("GL_ARB_multi_draw_indirect",
+                                                                            "glMultiDrawElementsIndirect");
+    }
+}
@@ -0,0 +1,50 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef EXTENSIONS_H
+#define EXTENSIONS_H
+
+#include "glad/gl.h"
+
+// The context is created as OpenGL 4.1, the loader does not know the tokens of later extensions
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+
+/**
+ * Optional extensions loaded at runtime, a null function pointer means the extension is not supported and the caller
+ * must take its GL 4.1 fallback path
+ */
+class Extensions
+{
+public:
+    using BufferStorageProc = void (GLAD_API_PTR*)(GLenum target, GLsizeiptr size, const void* data,
+                                                   GLbitfield flags);
+
+    using MultiDrawElementsIndirectProc = void (GLAD_API_PTR*)(GLenum mode, GLenum type, const void* indirect,
+                                                               GLsizei drawCount, GLsizei stride);
+
+    static inline BufferStorageProc bufferStorage{nullptr};
+    static inline MultiDrawElementsIndirectProc multiDrawElementsIndirect{nullptr};
+
+    /**
+     * Must be called once the context is current and the loader initialized
+     */
+    static auto load() -> void;
+
+    [[nodiscard]] static auto hasBufferStorage() -> bool { return bufferStorage != nullptr; }
+
+    /**
+     * Only loaded with ARB_base_instance, the baseInstance field of the commands is ignored without it
+     */
+    [[nodiscard]] static auto hasMultiDrawIndirect() -> bool { return multiDrawElementsIndirect != nullptr; }
+};
+
+#endif //EXTENSIONS_H
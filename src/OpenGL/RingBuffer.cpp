@@ -0,0 +1,195 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "Extensions.h"
+#include "VertexArray.h"
+
+auto RingBuffer::Create(const GLsizeiptr regionSize, const GLsizeiptr alignment) -> RingBuffer
+{
+    RingBuffer ringBuffer;
+
+    ringBuffer.m_alignment = std::max<GLsizeiptr>(alignment, 1);
+    ringBuffer.m_persistent = Extensions::hasBufferStorage();
+    ringBuffer.m_regionSize = ringBuffer.alignedSize(regionSize);
+
+    if (!ringBuffer.m_persistent)
+    {
+        ringBuffer.useStaging();
+        return ringBuffer;
+    }
+
+    // A failed mapping switches the ring to the staging fallback, which stops the loop
+    ringBuffer.m_regions.resize(RegionCount);
+    for (size_t i = 0; i < RegionCount && ringBuffer.m_persistent; ++i)
+        (void)ringBuffer.createRegion(ringBuffer.m_regions[i], ringBuffer.m_regionSize);
+
+    return ringBuffer;
+}
+
+RingBuffer::RingBuffer(RingBuffer&& other) noexcept
+    : m_regions(std::move(other.m_regions)),
+      m_regionSize(std::exchange(other.m_regionSize, 0)),
+      m_alignment(other.m_alignment),
+      m_persistent(other.m_persistent),
+      m_staging(std::move(other.m_staging)),
+      m_region(std::exchange(other.m_region, 0)),
+      m_head(std::exchange(other.m_head, 0))
+{
+    other.m_regions.clear();
+}
+
+RingBuffer::~RingBuffer()
+{
+    for (auto& region : m_regions)
+        releaseRegion(region);
+}
+
+auto RingBuffer::operator=(RingBuffer&& other) noexcept -> RingBuffer&
+{
+    std::swap(m_regions, other.m_regions);
+    std::swap(m_regionSize, other.m_regionSize);
+    std::swap(m_alignment, other.m_alignment);
+    std::swap(m_persistent, other.m_persistent);
+    std::swap(m_staging, other.m_staging);
+    std::swap(m_region, other.m_region);
+    std::swap(m_head, other.m_head);
+    return *this;
+}
+
+auto RingBuffer::createRegion(Region& region, const GLsizeiptr size) -> bool
+{
+    region.size = size;
+
+    // The copy target leaves the vertex array and uniform buffer bindings untouched
+    glGenBuffers(1, &region.id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, region.id);
+
+    if (!m_persistent)
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        return true;
+    }
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    Extensions::bufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+    region.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+    if (region.mapped != nullptr)
+        return true;
+
+    // Mapping failed, use the fallback for the lifetime of this ring
+    useStaging();
+    return false;
+}
+
+auto RingBuffer::releaseRegion(Region& region) -> void
+{
+    if (region.fence != nullptr)
+        glDeleteSync(std::exchange(region.fence, nullptr));
+
+    if (region.mapped != nullptr)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, region.id);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        region.mapped = nullptr;
+    }
+
+    // Draws still reading the buffer keep its storage alive until they complete
+    VertexArray::forgetArrayBuffer(region.id);
+    glDeleteBuffers(1, &region.id);
+    region.id = 0;
+}
+
+auto RingBuffer::useStaging() -> void
+{
+    for (auto& region : m_regions)
+        releaseRegion(region);
+
+    m_persistent = false;
+    m_regions.assign(1, {});
+    m_region = 0;
+    m_staging.resize(m_regionSize);
+    (void)createRegion(m_regions[0], m_regionSize);
+}
+
+auto RingBuffer::replaceRegion(const GLsizeiptr size) -> void
+{
+    releaseRegion(m_regions[m_region]);
+    (void)createRegion(m_regions[m_region], size);
+}
+
+auto RingBuffer::beginFrame(const GLsizeiptr requiredSize) -> void
+{
+    m_head = 0;
+    if (requiredSize > m_regionSize)
+        m_regionSize = alignedSize(std::max(requiredSize, m_regionSize * 2));
+
+    if (!m_persistent)
+    {
+        // The single region is orphaned by every flushWrites, growing it is enough
+        if (m_regions[0].size < m_regionSize)
+        {
+            m_staging.resize(m_regionSize);
+            m_regions[0].size = m_regionSize;
+        }
+        return;
+    }
+
+    m_region = (m_region + 1) % m_regions.size();
+    Region& region = m_regions[m_region];
+    if (region.fence != nullptr)
+    {
+        // Never waits, the frame writes to another region instead of stalling on the GPU
+        if (glClientWaitSync(region.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            if (m_regions.size() < MaxRegionCount)
+            {
+                // The busy region moves after the new one, it gets a whole extra frame to complete
+                m_regions.insert(m_regions.begin() + static_cast<std::ptrdiff_t>(m_region), Region{});
+                (void)createRegion(m_regions[m_region], m_regionSize);
+            }
+            else
+                replaceRegion(m_regionSize);
+            return;
+        }
+        glDeleteSync(std::exchange(region.fence, nullptr));
+    }
+
+    if (region.size < requiredSize)
+        replaceRegion(m_regionSize);
+}
+
+auto RingBuffer::allocate(const GLsizeiptr size) -> Allocation
+{
+    assert(m_head + size <= m_regions[m_region].size && "Allocation not reserved by beginFrame");
+
+    const GLsizeiptr offset = m_head;
+    m_head += alignedSize(size);
+
+    unsigned char* base = m_persistent ? m_regions[m_region].mapped : m_staging.data();
+    return {.data = base + offset, .offset = offset};
+}
+
+auto RingBuffer::flushWrites() -> void
+{
+    if (m_persistent || m_head == 0)
+        return; // The mapping is coherent
+
+    // Orphan the previous storage, so the driver does not wait for last frame draws
+    const Region& region = m_regions[m_region];
+    glBindBuffer(GL_COPY_WRITE_BUFFER, region.id);
+    glBufferData(GL_COPY_WRITE_BUFFER, region.size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, m_head, m_staging.data());
+}
+
+auto RingBuffer::endFrame() -> void
+{
+    if (m_persistent)
+        m_regions[m_region].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,108 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "glad/gl.h"
+
+/**
+ * Per-frame streaming buffer split in regions, the CPU writes one region while the GPU reads the others.
+ * With ARB_buffer_storage each region is a persistently mapped buffer, reused once the fence of the frame that last
+ * used it is signaled. The fence is only polled: a region the GPU still reads gets a new region inserted before it, up
+ * to MaxRegionCount, past that its storage alone is replaced. Without it, writes go to a CPU copy uploaded in one
+ * orphaned glBufferSubData.
+ */
+class RingBuffer
+{
+public:
+    static constexpr size_t RegionCount = 3; // Initial regions
+    static constexpr size_t MaxRegionCount = 6;
+
+    struct Allocation
+    {
+        void* data;
+        GLintptr offset; // Offset in the buffer, to bind the allocation with
+    };
+
+private:
+    struct Region
+    {
+        GLuint id{0};
+        GLsizeiptr size{0};
+        unsigned char* mapped{nullptr};
+        GLsync fence{nullptr};
+    };
+
+    std::vector<Region> m_regions;
+    GLsizeiptr m_regionSize{0}; // Of new regions, the largest size requested so far
+    GLsizeiptr m_alignment{1};
+    bool m_persistent{false};
+
+    std::vector<unsigned char> m_staging; // Used instead of the mapping when the buffer is not persistent
+
+    size_t m_region{0};
+    GLsizeiptr m_head{0};
+
+    /**
+     * False when the mapping failed, the ring then falls back to a single region uploaded from m_staging
+     */
+    [[nodiscard]] auto createRegion(Region& region, GLsizeiptr size) -> bool;
+    static auto releaseRegion(Region& region) -> void;
+    auto useStaging() -> void;
+    auto replaceRegion(GLsizeiptr size) -> void;
+
+public:
+    /**
+     * alignment is the required alignment of every allocation offset, e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+     */
+    static auto Create(GLsizeiptr regionSize, GLsizeiptr alignment) -> RingBuffer;
+
+    RingBuffer() = default;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer(RingBuffer&& other) noexcept;
+    ~RingBuffer();
+
+    auto operator=(const RingBuffer&) -> RingBuffer& = delete;
+    auto operator=(RingBuffer&& other) noexcept -> RingBuffer&;
+
+    /**
+     * Switch to the next region, growing it when requiredSize bytes (alignment included) do not fit. Never waits
+     * for the GPU
+     */
+    auto beginFrame(GLsizeiptr requiredSize) -> void;
+
+    /**
+     * Take size bytes from the current region, which must have been reserved by beginFrame
+     */
+    auto allocate(GLsizeiptr size) -> Allocation;
+
+    /**
+     * Make the writes of the current region visible to the GPU, must be called before the draws reading them
+     */
+    auto flushWrites() -> void;
+
+    /**
+     * Fence the current region, after the last draw reading it
+     */
+    auto endFrame() -> void;
+
+    /**
+     * Buffer of the current region, allocation offsets are relative to it
+     */
+    [[nodiscard]] auto id() const -> GLuint { return m_regions.empty() ? 0 : m_regions[m_region].id; }
+    [[nodiscard]] auto alignment() const -> GLsizeiptr { return m_alignment; }
+    [[nodiscard]] auto persistent() const -> bool { return m_persistent; }
+
+    [[nodiscard]] auto alignedSize(const GLsizeiptr size) const -> GLsizeiptr
+    {
+        return (size + m_alignment - 1) / m_alignment * m_alignment;
+    }
+};
+
+#endif //RINGBUFFER_H
@@ -90,6 +90,10 @@ auto ShaderProgram::getCodeWithFlags(const std::string_view& code, const ShaderF
         defines += "#define HAS_VEC3_COLORS\n";
     if (flags & ShaderHasVec4Colors)
         defines += "#define HAS_VEC4_COLORS\n";
+    if (flags & ShaderHasInstanceTransforms)
+        defines += "#define HAS_INSTANCE_TRANSFORMS\n";
+    if (flags & ShaderHasOctahedralNormals)
+        defines += "#define HAS_OCTAHEDRAL_NORMALS\n";
 
     auto copy = std::string(code);
     if (defines.empty())
@@ -124,7 +128,9 @@ auto GetPrimitiveShaderFlags(const tinygltf::Model& model, const tinygltf::Primi
     ShaderFlags primitiveShaderFlags = ShaderHasNone; // TODO store flags in primitive when loading to avoid recalculate
     for (const auto& [attribute, accessorId] : primitive.attributes)
     {
-        if (attribute == "NORMAL")
+        if (attribute == "NORMAL" && model.accessors[accessorId].type == TINYGLTF_TYPE_VEC2)
+            primitiveShaderFlags |= ShaderHasNormals | ShaderHasOctahedralNormals;
+        else if (attribute == "NORMAL")
             primitiveShaderFlags |= ShaderHasNormals;
         else if (attribute == "TANGENT")
             primitiveShaderFlags |= ShaderHasTangents;
@@ -10,7 +10,7 @@
 #include "ShaderProgramInstance.h"
 #include "Utility/EnumHelpers.h"
 
-enum ShaderFlags : unsigned char
+enum ShaderFlags : unsigned short
 {
     ShaderHasNone = 0,
     ShaderHasNormals = 1 << 0,
@@ -21,6 +21,8 @@ enum ShaderFlags : unsigned char
     ShaderHasEmissiveMap = 1 << 5,
     ShaderHasVec3Colors = 1 << 6,
     ShaderHasVec4Colors = 1 << 7,
+    ShaderHasInstanceTransforms = 1 << 8,
+    ShaderHasOctahedralNormals = 1 << 9, // Two snorm components, see MeshQuantizer
 };
 
 MAKE_FLAG_ENUM(ShaderFlags)
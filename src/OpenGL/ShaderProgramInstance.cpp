@@ -1,3 +1,4 @@
+#include <cassert>
 #include <fstream>
 #include <sstream>
 
@@ -40,6 +41,36 @@ auto ShaderProgramInstance::Create(const std::string_view& vertexCode, const std
 ShaderProgramInstance::ShaderProgramInstance(const GLuint id, Shader&& vertShader, Shader&& fragShader)
     : m_id(id), m_vertShader(std::move(vertShader)), m_fragShader(std::move(fragShader))
 {
+    resolveUniforms();
+    bindUniformBlocks();
+}
+
+auto ShaderProgramInstance::resolveUniforms() -> void
+{
+    GLint activeUniforms = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &activeUniforms);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::string name(maxNameLength, '\0');
+    for (GLint i = 0; i < activeUniforms; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_id, i, maxNameLength, &length, &size, &type, name.data());
+
+        const auto nameView = std::string_view(name.data(), length);
+        for (size_t id = 0; id < UniformCount; ++id)
+        {
+            if (UniformNames[id] == nameView)
+            {
+                m_uniforms[id].location = glGetUniformLocation(m_id, name.c_str());
+                m_uniforms[id].type = type;
+                break;
+            }
+        }
+    }
 }
 
 auto ShaderProgramInstance::use() const -> void
@@ -47,67 +78,71 @@ auto ShaderProgramInstance::use() const -> void
     glUseProgram(m_id);
 }
 
-auto ShaderProgramInstance::setBool(const std::string_view& name, const bool value) -> void
+auto ShaderProgramInstance::bindUniformBlocks() const -> void
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_bools, &nullTerminated))
+    // GLSL 410 has no binding layout qualifier, blocks are attached to their binding point here
+    for (GLuint binding = 0; binding < UniformBlockCount; ++binding)
     {
-        glUniform1i(glGetUniformLocation(m_id, nullTerminated->c_str()), static_cast<GLint>(value));
+        const GLuint blockIndex = glGetUniformBlockIndex(m_id, UniformBlockNames[binding]);
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(m_id, blockIndex, binding);
     }
 }
 
-void ShaderProgramInstance::setInt(const std::string_view& name, const GLint value)
+auto ShaderProgramInstance::setBool(const UniformId id, const bool value) -> void
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_ints, &nullTerminated))
-    {
-        glUniform1i(glGetUniformLocation(m_id, nullTerminated->c_str()), value);
-    }
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_BOOL);
+    if (storeUniformValue(target, value))
+        glUniform1i(target.location, static_cast<GLint>(value));
 }
 
-void ShaderProgramInstance::setUint(const std::string_view& name, const GLuint value)
+void ShaderProgramInstance::setInt(const UniformId id, const GLint value)
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_uints, &nullTerminated))
-    {
-        glUniform1ui(glGetUniformLocation(m_id, nullTerminated->c_str()), value);
-    }
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_INT || target.type == GL_SAMPLER_2D);
+    if (storeUniformValue(target, value))
+        glUniform1i(target.location, value);
 }
 
-auto ShaderProgramInstance::setFloat(const std::string_view& name, const float value) -> void
+void ShaderProgramInstance::setUint(const UniformId id, const GLuint value)
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_floats, &nullTerminated))
-    {
-        glUniform1f(glGetUniformLocation(m_id, nullTerminated->c_str()), value);
-    }
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_UNSIGNED_INT);
+    if (storeUniformValue(target, value))
+        glUniform1ui(target.location, value);
 }
 
-auto ShaderProgramInstance::setVec3(const std::string_view& name, const glm::vec3& value) -> void
+auto ShaderProgramInstance::setFloat(const UniformId id, const float value) -> void
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_vec3s, &nullTerminated))
-    {
-        glUniform3f(glGetUniformLocation(m_id, nullTerminated->c_str()), value.x, value.y, value.z);
-    }
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_FLOAT);
+    if (storeUniformValue(target, value))
+        glUniform1f(target.location, value);
 }
 
-auto ShaderProgramInstance::setVec4(const std::string_view& name, const glm::vec4& value) -> void
+auto ShaderProgramInstance::setVec3(const UniformId id, const glm::vec3& value) -> void
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_vec4s, &nullTerminated))
-    {
-        glUniform4f(glGetUniformLocation(m_id, nullTerminated->c_str()), value.x, value.y, value.z, value.w);
-    }
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_FLOAT_VEC3);
+    if (storeUniformValue(target, value))
+        glUniform3f(target.location, value.x, value.y, value.z);
 }
 
-auto ShaderProgramInstance::setMat4(const std::string_view& name, const glm::mat4& value) -> void
+auto ShaderProgramInstance::setVec4(const UniformId id, const glm::vec4& value) -> void
 {
-    const std::string* nullTerminated;
-    if (storeUniformValue(name, value, m_mat4s, &nullTerminated))
-    {
-        glUniformMatrix4fv(glGetUniformLocation(m_id, nullTerminated->c_str()), 1, GL_FALSE, glm::value_ptr(value));
-    }
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_FLOAT_VEC4);
+    if (storeUniformValue(target, value))
+        glUniform4f(target.location, value.x, value.y, value.z, value.w);
+}
+
+auto ShaderProgramInstance::setMat4(const UniformId id, const glm::mat4& value) -> void
+{
+    auto& target = uniform(id);
+    assert(target.location < 0 || target.type == GL_FLOAT_MAT4);
+    if (storeUniformValue(target, value))
+        glUniformMatrix4fv(target.location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 auto ShaderProgramInstance::linkProgram(const GLuint id) -> Expected<void, std::string>
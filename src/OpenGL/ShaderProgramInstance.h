@@ -1,21 +1,71 @@
 #ifndef SHADER_PROGRAM_H
 #define SHADER_PROGRAM_H
 
+#include <array>
+#include <cstring>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 #include "Expected.h"
 #include "Shader.h"
-#include "StringUnorderedMap.h"
 
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 
+/**
+ * Uniforms known by the engine, resolved once after link
+ */
+enum class UniformId : unsigned char
+{
+    BaseColorTexture,
+    NormalMap,
+    BoundsMin,
+    BoundsMax,
+    Count,
+};
+
+/**
+ * Uniform blocks known by the engine, the value is also the binding point of the block
+ */
+enum class UniformBlockId : unsigned char
+{
+    Frame,
+    Draw,
+    Count,
+};
+
 class ShaderProgramInstance
 {
+public:
+    static constexpr size_t UniformCount = static_cast<size_t>(UniformId::Count);
+
+    static constexpr std::array<std::string_view, UniformCount> UniformNames{
+        "u_baseColorTexture",
+        "u_normalMap",
+        "u_boundsMin",
+        "u_boundsMax",
+    };
+
+    static constexpr size_t UniformBlockCount = static_cast<size_t>(UniformBlockId::Count);
+
+    static constexpr std::array<const char*, UniformBlockCount> UniformBlockNames{
+        "FrameUniforms",
+        "DrawUniforms",
+    };
+
+private:
+    struct Uniform
+    {
+        GLint location{-1}; // -1 when the variant does not use it, setting it is then a no-op
+        GLenum type{0};
+        bool hasValue{false};
+        alignas(glm::mat4) unsigned char value[sizeof(glm::mat4)]{}; // Last value sent, to skip redundant uploads
+    };
+
     GLuint m_id;
     Shader m_vertShader;
     Shader m_fragShader;
+    std::array<Uniform, UniformCount> m_uniforms{};
 
 public:
     static auto Create(const std::string_view& vertexCode, const std::string_view& fragCode)
@@ -33,13 +83,7 @@ public:
         : m_id(std::exchange(other.m_id, 0)),
           m_vertShader(std::exchange(other.m_vertShader, {})),
           m_fragShader(std::exchange(other.m_fragShader, {})),
-          m_bools(std::exchange(other.m_bools, {})),
-          m_ints(std::exchange(other.m_ints, {})),
-          m_uints(std::exchange(other.m_uints, {})),
-          m_floats(std::exchange(other.m_floats, {})),
-          m_vec3s(std::exchange(other.m_vec3s, {})),
-          m_vec4s(std::exchange(other.m_vec4s, {})),
-          m_mat4s(std::exchange(other.m_mat4s, {}))
+          m_uniforms(std::exchange(other.m_uniforms, {}))
     {
     }
 
@@ -55,13 +99,7 @@ public:
         std::swap(m_id, other.m_id);
         std::swap(m_vertShader, other.m_vertShader);
         std::swap(m_fragShader, other.m_fragShader);
-        std::swap(m_bools, other.m_bools);
-        std::swap(m_ints, other.m_ints);
-        std::swap(m_uints, other.m_uints);
-        std::swap(m_floats, other.m_floats);
-        std::swap(m_vec3s, other.m_vec3s);
-        std::swap(m_vec4s, other.m_vec4s);
-        std::swap(m_mat4s, other.m_mat4s);
+        std::swap(m_uniforms, other.m_uniforms);
         return *this;
     }
 
@@ -69,44 +107,46 @@ public:
 
     void use() const;
 
-    void setBool(const std::string_view& name, bool value);
-    void setInt(const std::string_view& name, GLint value);
-    void setUint(const std::string_view& name, GLuint value);
-    void setFloat(const std::string_view& name, float value);
-    void setVec3(const std::string_view& name, const glm::vec3& value);
-    void setVec4(const std::string_view& name, const glm::vec4& value);
-    void setMat4(const std::string_view& name, const glm::mat4& value);
+    [[nodiscard]] auto uniformLocation(const UniformId id) const -> GLint { return uniform(id).location; }
 
-private:
-    StringUnorderedMap<bool> m_bools;
-    StringUnorderedMap<GLint> m_ints;
-    StringUnorderedMap<GLuint> m_uints;
-    StringUnorderedMap<float> m_floats;
-    StringUnorderedMap<glm::vec3> m_vec3s;
-    StringUnorderedMap<glm::vec4> m_vec4s;
-    StringUnorderedMap<glm::mat4> m_mat4s;
+    void setBool(UniformId id, bool value);
+    void setInt(UniformId id, GLint value);
+    void setUint(UniformId id, GLuint value);
+    void setFloat(UniformId id, float value);
+    void setVec3(UniformId id, const glm::vec3& value);
+    void setVec4(UniformId id, const glm::vec4& value);
+    void setMat4(UniformId id, const glm::mat4& value);
 
+private:
     static auto linkProgram(GLuint id) -> Expected<void, std::string>;
 
+    auto resolveUniforms() -> void;
+    auto bindUniformBlocks() const -> void;
+
+    [[nodiscard]] auto uniform(const UniformId id) -> Uniform& { return m_uniforms[static_cast<size_t>(id)]; }
+
+    [[nodiscard]] auto uniform(const UniformId id) const -> const Uniform&
+    {
+        return m_uniforms[static_cast<size_t>(id)];
+    }
+
+    /**
+     * Store the value of a uniform, returns true when it must be sent to the program
+     */
     template <typename T>
-    static bool storeUniformValue(const std::string_view& name, T value, StringUnorderedMap<T>& map,
-                                  const std::string** nullTerminatedString)
+    static bool storeUniformValue(Uniform& uniform, const T& value)
     {
-        const auto it = map.find(name);
-        if (it == map.end())
-        {
-            const auto inserted = map.emplace(std::string(name), value);
-            *nullTerminatedString = &inserted.first->first;
-            return true;
-        }
-
-        *nullTerminatedString = &it->first;
-        if (it->second != value)
-        {
-            it->second = value;
-            return true;
-        }
-        return false;
+        static_assert(sizeof(T) <= sizeof(Uniform::value));
+
+        if (uniform.location < 0)
+            return false;
+
+        if (uniform.hasValue && std::memcmp(uniform.value, &value, sizeof(T)) == 0)
+            return false;
+
+        std::memcpy(uniform.value, &value, sizeof(T));
+        uniform.hasValue = true;
+        return true;
     }
 };
 
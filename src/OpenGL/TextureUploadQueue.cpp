@@ -0,0 +1,209 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "TextureUploadQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+auto TextureUploadQueue::Create(const size_t frameBudget) -> TextureUploadQueue
+{
+    TextureUploadQueue queue;
+    queue.m_frameBudget = std::max<size_t>(frameBudget, 1);
+
+    glGenBuffers(BufferCount, queue.m_buffers.data());
+    for (size_t i = 0; i < BufferCount; ++i)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, queue.m_buffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(queue.m_frameBudget), nullptr, GL_STREAM_DRAW);
+        queue.m_bufferSizes[i] = static_cast<GLsizeiptr>(queue.m_frameBudget);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // White, the base color factor of the material shows until the texture is ready
+    constexpr unsigned char white[4] = {255, 255, 255, 255};
+    glGenTextures(1, &queue.m_placeholder);
+    glBindTexture(GL_TEXTURE_2D, queue.m_placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return queue;
+}
+
+TextureUploadQueue::TextureUploadQueue(TextureUploadQueue&& other) noexcept
+    : m_buffers(std::exchange(other.m_buffers, {})),
+      m_bufferSizes(std::exchange(other.m_bufferSizes, {})),
+      m_fences(std::exchange(other.m_fences, {})),
+      m_buffer(other.m_buffer),
+      m_frameBudget(other.m_frameBudget),
+      m_placeholder(std::exchange(other.m_placeholder, 0)),
+      m_uploads(std::move(other.m_uploads)),
+      m_pending(std::move(other.m_pending))
+{
+}
+
+TextureUploadQueue::~TextureUploadQueue()
+{
+    release();
+}
+
+auto TextureUploadQueue::operator=(TextureUploadQueue&& other) noexcept -> TextureUploadQueue&
+{
+    std::swap(m_buffers, other.m_buffers);
+    std::swap(m_bufferSizes, other.m_bufferSizes);
+    std::swap(m_fences, other.m_fences);
+    std::swap(m_buffer, other.m_buffer);
+    std::swap(m_frameBudget, other.m_frameBudget);
+    std::swap(m_placeholder, other.m_placeholder);
+    std::swap(m_uploads, other.m_uploads);
+    std::swap(m_pending, other.m_pending);
+    return *this;
+}
+
+auto TextureUploadQueue::release() -> void
+{
+    for (auto& fence : m_fences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(std::exchange(fence, nullptr));
+    }
+
+    if (m_buffers[0] != 0)
+        glDeleteBuffers(BufferCount, m_buffers.data());
+    m_buffers = {};
+
+    if (m_placeholder != 0)
+        glDeleteTextures(1, &m_placeholder);
+    m_placeholder = 0;
+}
+
+auto TextureUploadQueue::acquireBuffer(const GLsizeiptr size) -> bool
+{
+    GLsync& fence = m_fences[m_buffer];
+    if (fence != nullptr)
+    {
+        // Never waits, a buffer the GPU still reads delays the uploads by a frame instead of stalling it
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(std::exchange(fence, nullptr));
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[m_buffer]);
+    if (size > m_bufferSizes[m_buffer])
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        m_bufferSizes[m_buffer] = size;
+    }
+    return true;
+}
+
+auto TextureUploadQueue::enqueue(const GLuint texture, const GLint internalFormat, const GLsizei width,
+                                 const GLsizei height, const GLenum format, const GLenum type,
+                                 const std::span<const unsigned char> pixels) -> void
+{
+    assert(width > 0 && height > 0 && pixels.size() % height == 0);
+
+    // Storage only, no copy of client memory
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+
+    m_uploads.push_back({
+        .texture = texture,
+        .width = width,
+        .height = height,
+        .format = format,
+        .type = type,
+        .pixels = pixels,
+        .rowSize = pixels.size() / height,
+    });
+    m_pending.insert(texture);
+}
+
+auto TextureUploadQueue::update() -> size_t
+{
+    if (m_uploads.empty())
+        return 0;
+
+    struct Chunk
+    {
+        Upload* upload;
+        GLsizei rowCount;
+        size_t offset;
+    };
+
+    // Rows of the uploads in queue order, the last one may be cut by the budget
+    std::vector<Chunk> chunks;
+    size_t size = 0;
+    for (auto& upload : m_uploads)
+    {
+        // 4 bytes aligned offsets suit every component type
+        const size_t offset = (size + 3) & ~size_t{3};
+        const size_t budget = m_frameBudget > offset ? m_frameBudget - offset : 0;
+        auto rowCount = static_cast<GLsizei>(std::min<size_t>(budget / upload.rowSize,
+                                                              upload.height - upload.nextRow));
+        if (rowCount == 0 && chunks.empty())
+            rowCount = 1;
+        if (rowCount == 0)
+            break;
+
+        chunks.push_back({.upload = &upload, .rowCount = rowCount, .offset = offset});
+        size = offset + rowCount * upload.rowSize;
+        if (upload.nextRow + rowCount < upload.height)
+            break;
+    }
+
+    if (!acquireBuffer(static_cast<GLsizeiptr>(size)))
+        return 0;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    auto* mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                                                static_cast<GLsizeiptr>(size), flags));
+    if (mapped == nullptr)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+
+    for (const auto& [upload, rowCount, offset] : chunks)
+        std::memcpy(mapped + offset, upload->pixels.data() + upload->nextRow * upload->rowSize,
+                    rowCount * upload->rowSize);
+
+    // The storage was lost, e.g. on a mode switch, the same rows are copied again next frame
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (const auto& [upload, rowCount, offset] : chunks)
+    {
+        glBindTexture(GL_TEXTURE_2D, upload->texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload->nextRow, upload->width, rowCount, upload->format,
+                        upload->type, reinterpret_cast<const void*>(offset));
+        upload->nextRow += rowCount;
+
+        // Commands run in order, draws sampling the texture after this see every level
+        if (upload->nextRow == upload->height)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            m_pending.erase(upload->texture);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    m_fences[m_buffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_buffer = (m_buffer + 1) % BufferCount;
+
+    while (!m_uploads.empty() && m_uploads.front().nextRow == m_uploads.front().height)
+        m_uploads.pop_front();
+
+    return size;
+}
@@ -0,0 +1,93 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef TEXTUREUPLOADQUEUE_H
+#define TEXTUREUPLOADQUEUE_H
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <unordered_set>
+
+#include "glad/gl.h"
+
+/**
+ * Streams texture images to the GPU a few rows at a time. Every frame update copies up to a byte budget of pending
+ * rows in one pixel buffer of a pool of BufferCount, and the driver copies them to the textures without blocking. A
+ * buffer is only reused once the fence of the frame that filled it is signaled, otherwise the frame uploads nothing.
+ * Textures are sampled through resolve, which gives a placeholder until their last rows and mipmaps are submitted
+ */
+class TextureUploadQueue
+{
+public:
+    static constexpr size_t BufferCount = 3;
+
+private:
+    struct Upload
+    {
+        GLuint texture;
+        GLsizei width;
+        GLsizei height;
+        GLenum format;
+        GLenum type;
+        std::span<const unsigned char> pixels; // Tightly packed rows, owned by the caller
+        size_t rowSize;
+        GLsizei nextRow{0};
+    };
+
+    std::array<GLuint, BufferCount> m_buffers{};
+    std::array<GLsizeiptr, BufferCount> m_bufferSizes{};
+    std::array<GLsync, BufferCount> m_fences{};
+    size_t m_buffer{0};
+    size_t m_frameBudget{0};
+
+    GLuint m_placeholder{0};
+    std::deque<Upload> m_uploads;
+    std::unordered_set<GLuint> m_pending;
+
+    auto release() -> void;
+    [[nodiscard]] auto acquireBuffer(GLsizeiptr size) -> bool;
+
+public:
+    /**
+     * frameBudget is the most bytes copied per update, a row larger than it is still copied alone
+     */
+    static auto Create(size_t frameBudget) -> TextureUploadQueue;
+
+    TextureUploadQueue() = default;
+    TextureUploadQueue(const TextureUploadQueue&) = delete;
+    TextureUploadQueue(TextureUploadQueue&& other) noexcept;
+    ~TextureUploadQueue();
+
+    auto operator=(const TextureUploadQueue&) -> TextureUploadQueue& = delete;
+    auto operator=(TextureUploadQueue&& other) noexcept -> TextureUploadQueue&;
+
+    /**
+     * Allocates the level 0 of texture, bound to GL_TEXTURE_2D, and queues its pixels, which must stay alive until
+     * the texture is no longer pending. Mipmaps are generated after the last rows
+     */
+    auto enqueue(GLuint texture, GLint internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                 std::span<const unsigned char> pixels) -> void;
+
+    /**
+     * Copies the next rows, once per frame before the draws. Leaves GL_TEXTURE_2D of the active unit unbound when it
+     * uploaded anything, and returns the number of bytes copied
+     */
+    auto update() -> size_t;
+
+    /**
+     * The texture to bind for texture, the placeholder while it is pending
+     */
+    [[nodiscard]] auto resolve(const GLuint texture) const -> GLuint
+    {
+        if (m_pending.empty() || !m_pending.contains(texture))
+            return texture;
+        return m_placeholder;
+    }
+
+    [[nodiscard]] auto pendingCount() const -> size_t { return m_pending.size(); }
+};
+
+#endif //TEXTUREUPLOADQUEUE_H
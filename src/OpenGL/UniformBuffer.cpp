@@ -0,0 +1,24 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "UniformBuffer.h"
+
+auto UniformBuffer::Create(const GLuint binding, const GLsizeiptr size) -> UniformBuffer
+{
+    GLuint id;
+
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+
+    return {id, binding, size};
+}
+
+auto UniformBuffer::write(const void* data) const -> void
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+    glBufferData(GL_UNIFORM_BUFFER, m_size, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, m_size, data);
+}
@@ -0,0 +1,64 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <utility>
+
+#include "glad/gl.h"
+
+/**
+ * Buffer attached to a fixed uniform block binding point, shared by every program declaring the block
+ */
+class UniformBuffer
+{
+private:
+    GLuint m_id{0};
+    GLuint m_binding{0};
+    GLsizeiptr m_size{0};
+
+public:
+    static auto Create(GLuint binding, GLsizeiptr size) -> UniformBuffer;
+
+    UniformBuffer() = default;
+
+    UniformBuffer(const GLuint id, const GLuint binding, const GLsizeiptr size)
+        : m_id(id), m_binding(binding), m_size(size)
+    {
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+
+    UniformBuffer(UniformBuffer&& other) noexcept
+        : m_id(std::exchange(other.m_id, 0)), m_binding(other.m_binding), m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    ~UniformBuffer()
+    {
+        glDeleteBuffers(1, &m_id);
+    }
+
+    auto operator=(const UniformBuffer&) -> UniformBuffer& = delete;
+
+    auto operator=(UniformBuffer&& other) noexcept -> UniformBuffer&
+    {
+        std::swap(m_id, other.m_id);
+        std::swap(m_binding, other.m_binding);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+
+    /**
+     * Replace the whole content of the buffer, orphaning the previous storage
+     */
+    auto write(const void* data) const -> void;
+
+    [[nodiscard]] auto id() const -> GLuint { return m_id; }
+    [[nodiscard]] auto binding() const -> GLuint { return m_binding; }
+    [[nodiscard]] auto size() const -> GLsizeiptr { return m_size; }
+};
+
+#endif //UNIFORMBUFFER_H
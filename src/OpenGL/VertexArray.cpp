@@ -19,6 +19,14 @@ auto VertexArray::Create(VertexArrayFlags flags) -> VertexArray
         glEnableVertexAttribArray(2);
     if (flags & VertexArrayHasTexCoord0)
         glEnableVertexAttribArray(3);
+    if (flags & VertexArrayHasInstanceTransform)
+    {
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            glEnableVertexAttribArray(InstanceTransformLocation + column);
+            glVertexAttribDivisor(InstanceTransformLocation + column, 1);
+        }
+    }
 
     return {flags, id};
 }
@@ -17,6 +17,7 @@ enum VertexArrayFlags : unsigned char
     VertexArrayHasNormal = 1 << 1,
     VertexArrayHasColor0 = 1 << 2,
     VertexArrayHasTexCoord0 = 1 << 3,
+    VertexArrayHasInstanceTransform = 1 << 4,
 };
 
 MAKE_FLAG_ENUM(VertexArrayFlags)
@@ -26,9 +27,11 @@ class VertexArray
 private:
     VertexArrayFlags m_flags{VertexArrayHasNone};
     GLuint m_id{0};
-    GLuint m_currentlyBoundArrayBuffer{0};
     GLuint m_currentlyBoundArrayElementBuffer{0};
 
+    // GL_ARRAY_BUFFER is not part of the vertex array state, so the binding is shared by all of them
+    static inline GLuint s_currentlyBoundArrayBuffer{0};
+
     static inline const StringUnorderedMap<int> attributeLocations{
         {"POSITION", 0},
         {"NORMAL", 1},
@@ -37,6 +40,8 @@ private:
     };
 
 public:
+    static constexpr GLuint InstanceTransformLocation = 4; // A mat4 spans locations 4 to 7
+
     static auto Create(VertexArrayFlags flags) -> VertexArray;
 
     VertexArray() = default;
@@ -47,7 +52,9 @@ public:
 
     VertexArray(const VertexArray&) = delete;
 
-    VertexArray(VertexArray&& other) noexcept : m_flags(other.m_flags), m_id(std::exchange(other.m_id, 0))
+    VertexArray(VertexArray&& other) noexcept
+        : m_flags(other.m_flags), m_id(std::exchange(other.m_id, 0)),
+          m_currentlyBoundArrayElementBuffer(std::exchange(other.m_currentlyBoundArrayElementBuffer, 0))
     {
     }
 
@@ -62,6 +69,7 @@ public:
     {
         m_flags = other.m_flags;
         std::swap(m_id, other.m_id);
+        std::swap(m_currentlyBoundArrayElementBuffer, other.m_currentlyBoundArrayElementBuffer);
         return *this;
     }
 
@@ -70,15 +78,24 @@ public:
         glBindVertexArray(m_id);
     }
 
-    auto bindArrayBuffer(const GLuint id) -> void
+    static auto bindArrayBuffer(const GLuint id) -> void
     {
-        if (m_currentlyBoundArrayBuffer != id)
+        if (s_currentlyBoundArrayBuffer != id)
         {
             glBindBuffer(GL_ARRAY_BUFFER, id);
-            m_currentlyBoundArrayBuffer = id;
+            s_currentlyBoundArrayBuffer = id;
         }
     }
 
+    /**
+     * Must be called before deleting a buffer, a deleted name is often returned again by glGenBuffers
+     */
+    static auto forgetArrayBuffer(const GLuint id) -> void
+    {
+        if (s_currentlyBoundArrayBuffer == id)
+            s_currentlyBoundArrayBuffer = 0;
+    }
+
     auto bindElementArrayBuffer(const GLuint id) -> void
     {
         if (m_currentlyBoundArrayElementBuffer != id)
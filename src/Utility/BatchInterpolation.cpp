@@ -0,0 +1,136 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "BatchInterpolation.h"
+
+#include <cmath>
+
+// BATCH_INTERPOLATION_SCALAR forces the scalar kernels, so the tests compare every path on the same machine
+#if defined(BATCH_INTERPOLATION_SCALAR)
+#elif defined(__AVX__)
+#define BATCH_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#define BATCH_SSE
+#endif
+
+#if defined(BATCH_AVX) || defined(BATCH_SSE)
+#include <immintrin.h>
+#endif
+
+auto lerpBatch(const float* a, const float* b, const float* t, float* out, const size_t count) -> void
+{
+    size_t i = 0;
+
+#if defined(BATCH_AVX)
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 va = _mm256_loadu_ps(a + i);
+        const __m256 vb = _mm256_loadu_ps(b + i);
+        const __m256 vt = _mm256_loadu_ps(t + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(vb, va), vt)));
+    }
+#elif defined(BATCH_SSE)
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 va = _mm_loadu_ps(a + i);
+        const __m128 vb = _mm_loadu_ps(b + i);
+        const __m128 vt = _mm_loadu_ps(t + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt)));
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = a[i] + (b[i] - a[i]) * t[i];
+}
+
+auto quatDotBatch(const float* const a[4], const float* const b[4], float* out, const size_t count) -> void
+{
+    size_t i = 0;
+
+#if defined(BATCH_AVX)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 dot = _mm256_mul_ps(_mm256_loadu_ps(a[0] + i), _mm256_loadu_ps(b[0] + i));
+        for (int c = 1; c < 4; ++c)
+            dot = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_loadu_ps(a[c] + i), _mm256_loadu_ps(b[c] + i)));
+        _mm256_storeu_ps(out + i, dot);
+    }
+#elif defined(BATCH_SSE)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dot = _mm_mul_ps(_mm_loadu_ps(a[0] + i), _mm_loadu_ps(b[0] + i));
+        for (int c = 1; c < 4; ++c)
+            dot = _mm_add_ps(dot, _mm_mul_ps(_mm_loadu_ps(a[c] + i), _mm_loadu_ps(b[c] + i)));
+        _mm_storeu_ps(out + i, dot);
+    }
+#endif
+
+    for (; i < count; ++i)
+        out[i] = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+}
+
+auto quatBlendBatch(const float* const a[4], const float* const b[4], const float* wa, const float* wb,
+                    float* const out[4], const size_t count, const bool normalize) -> void
+{
+    size_t i = 0;
+
+#if defined(BATCH_AVX)
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 vwa = _mm256_loadu_ps(wa + i);
+        const __m256 vwb = _mm256_loadu_ps(wb + i);
+        __m256 result[4];
+        for (int c = 0; c < 4; ++c)
+            result[c] = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a[c] + i), vwa),
+                                      _mm256_mul_ps(_mm256_loadu_ps(b[c] + i), vwb));
+        if (normalize)
+        {
+            __m256 lengthSquared = _mm256_mul_ps(result[0], result[0]);
+            for (int c = 1; c < 4; ++c)
+                lengthSquared = _mm256_add_ps(lengthSquared, _mm256_mul_ps(result[c], result[c]));
+            const __m256 inverseLength = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSquared));
+            for (auto& component : result)
+                component = _mm256_mul_ps(component, inverseLength);
+        }
+        for (int c = 0; c < 4; ++c)
+            _mm256_storeu_ps(out[c] + i, result[c]);
+    }
+#elif defined(BATCH_SSE)
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 vwa = _mm_loadu_ps(wa + i);
+        const __m128 vwb = _mm_loadu_ps(wb + i);
+        __m128 result[4];
+        for (int c = 0; c < 4; ++c)
+            result[c] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a[c] + i), vwa), _mm_mul_ps(_mm_loadu_ps(b[c] + i), vwb));
+        if (normalize)
+        {
+            __m128 lengthSquared = _mm_mul_ps(result[0], result[0]);
+            for (int c = 1; c < 4; ++c)
+                lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(result[c], result[c]));
+            const __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+            for (auto& component : result)
+                component = _mm_mul_ps(component, inverseLength);
+        }
+        for (int c = 0; c < 4; ++c)
+            _mm_storeu_ps(out[c] + i, result[c]);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        float result[4];
+        for (int c = 0; c < 4; ++c)
+            result[c] = a[c][i] * wa[i] + b[c][i] * wb[i];
+        if (normalize)
+        {
+            const float inverseLength = 1.0f / std::sqrt(result[0] * result[0] + result[1] * result[1] +
+                                                         result[2] * result[2] + result[3] * result[3]);
+            for (auto& component : result)
+                component *= inverseLength;
+        }
+        for (int c = 0; c < 4; ++c)
+            out[c][i] = result[c];
+    }
+}
@@ -0,0 +1,30 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef BATCHINTERPOLATION_H
+#define BATCHINTERPOLATION_H
+
+#include <cstddef>
+
+// Interpolation kernels over structure-of-arrays data, vectorized with AVX or SSE when the compiler targets them,
+// with a scalar fallback for the tail and for other architectures, or everywhere with BATCH_INTERPOLATION_SCALAR.
+
+/**
+ * out[i] = a[i] + (b[i] - a[i]) * t[i]
+ */
+auto lerpBatch(const float* a, const float* b, const float* t, float* out, size_t count) -> void;
+
+/**
+ * out[i] = dot(a[i], b[i]) where a and b are quaternions split in four component arrays
+ */
+auto quatDotBatch(const float* const a[4], const float* const b[4], float* out, size_t count) -> void;
+
+/**
+ * out[i] = wa[i] * a[i] + wb[i] * b[i], normalized if `normalize` is set, for quaternions split in four component
+ * arrays
+ */
+auto quatBlendBatch(const float* const a[4], const float* const b[4], const float* wa, const float* wb,
+                    float* const out[4], size_t count, bool normalize) -> void;
+
+#endif //BATCHINTERPOLATION_H
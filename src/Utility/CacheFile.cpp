@@ -0,0 +1,36 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+#include "CacheFile.h"
+
+#include <filesystem>
+
+auto CacheFile::Write(const std::string& path, const uint32_t magic, const uint32_t version,
+                      const std::function<void(CacheWriter&)>& body) -> bool
+{
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        CacheWriter writer(file);
+        writer(magic, version);
+        body(writer);
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    return !error;
+}
+
+auto CacheFile::ReadHeader(CacheReader& reader, const uint32_t magic, const uint32_t version) -> bool
+{
+    uint32_t fileMagic = 0;
+    uint32_t fileVersion = 0;
+    reader(fileMagic, fileVersion);
+    return !reader.failed() && fileMagic == magic && fileVersion == version;
+}
@@ -0,0 +1,239 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+#ifndef CACHEFILE_H
+#define CACHEFILE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class CacheWriter;
+class CacheReader;
+
+/**
+ * Binary cache files written next to their source: a magic and a version, then a body serialized by CacheWriter
+ */
+class CacheFile
+{
+public:
+    static constexpr size_t BlobAlignment = 16; // Of the blobs in the file, so mapped blobs can be read in place
+
+    /**
+     * Writes the header then the body to path, through a temporary file renamed over it so an interrupted write never
+     * leaves a truncated cache. False when the file can't be written
+     */
+    static auto Write(const std::string& path, uint32_t magic, uint32_t version,
+                      const std::function<void(CacheWriter&)>& body) -> bool;
+
+    /**
+     * Reads the header written by Write, false when the file is truncated or has another magic or version
+     */
+    static auto ReadHeader(CacheReader& reader, uint32_t magic, uint32_t version) -> bool;
+};
+
+template <typename T>
+constexpr bool IsVector = false;
+
+template <typename T>
+constexpr bool IsVector<std::vector<T>> = true;
+
+template <typename T>
+constexpr bool IsMap = false;
+
+template <typename K, typename V>
+constexpr bool IsMap<std::map<K, V>> = true;
+
+/**
+ * Each type has a single serialize function shared by the writer and the reader, so both always agree on the
+ * layout. Arithmetic values are stored as is, a cache is only read back on the machine that wrote it.
+ * serialize(archive, value) overloads are found by argument dependent lookup, they are declared in the global
+ * namespace or in the namespace of the serialized type
+ */
+class CacheWriter
+{
+private:
+    std::ofstream& m_file;
+    size_t m_written{0};
+
+    auto writeBytes(const void* data, const size_t size) -> void
+    {
+        m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        m_written += size;
+    }
+
+    template <typename T>
+    auto write(const T& value) -> void
+    {
+        if constexpr (std::is_arithmetic_v<T>)
+            writeBytes(&value, sizeof(T));
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            write(static_cast<uint64_t>(value.size()));
+            writeBytes(value.data(), value.size());
+        }
+        else if constexpr (IsVector<T>)
+        {
+            write(static_cast<uint64_t>(value.size()));
+            if constexpr (std::is_arithmetic_v<typename T::value_type>)
+                writeBytes(value.data(), value.size() * sizeof(typename T::value_type));
+            else
+            {
+                for (const auto& element : value)
+                    write(element);
+            }
+        }
+        else if constexpr (IsMap<T>)
+        {
+            write(static_cast<uint64_t>(value.size()));
+            for (const auto& [key, mapped] : value)
+            {
+                write(key);
+                write(mapped);
+            }
+        }
+        else
+            serialize(*this, value);
+    }
+
+public:
+    template <typename T>
+    using Ref = const T&;
+
+    explicit CacheWriter(std::ofstream& file) : m_file(file)
+    {
+    }
+
+    template <typename... T>
+    auto operator()(const T&... values) -> void
+    {
+        (write(values), ...);
+    }
+
+    /**
+     * Raw bytes starting on a BlobAlignment boundary of the file, which the reader can view in place
+     */
+    auto blob(const std::vector<unsigned char>& bytes) -> void
+    {
+        write(static_cast<uint64_t>(bytes.size()));
+        static constexpr std::array<char, CacheFile::BlobAlignment> padding{};
+        const size_t aligned = (m_written + CacheFile::BlobAlignment - 1) & ~(CacheFile::BlobAlignment - 1);
+        writeBytes(padding.data(), aligned - m_written);
+        writeBytes(bytes.data(), bytes.size());
+    }
+};
+
+class CacheReader
+{
+private:
+    std::span<const unsigned char> m_bytes;
+    size_t m_offset{0};
+    bool m_failed{false};
+
+    auto view(const size_t size) -> std::span<const unsigned char>
+    {
+        if (m_failed || size > m_bytes.size() - m_offset)
+        {
+            m_failed = true;
+            return {};
+        }
+
+        const auto bytes = m_bytes.subspan(m_offset, size);
+        m_offset += size;
+        return bytes;
+    }
+
+    auto readBytes(void* data, const size_t size) -> void
+    {
+        const auto bytes = view(size);
+        if (!bytes.empty())
+            std::memcpy(data, bytes.data(), bytes.size());
+    }
+
+    // Never more elements than bytes left, a corrupted count can't allocate past the file size
+    auto readCount() -> size_t
+    {
+        uint64_t count = 0;
+        readBytes(&count, sizeof(count));
+        if (count > m_bytes.size() - m_offset)
+            m_failed = true;
+        return m_failed ? 0 : count;
+    }
+
+    template <typename T>
+    auto read(T& value) -> void
+    {
+        if constexpr (std::is_arithmetic_v<T>)
+            readBytes(&value, sizeof(T));
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            value.resize(readCount());
+            readBytes(value.data(), value.size());
+        }
+        else if constexpr (IsVector<T>)
+        {
+            value.resize(readCount());
+            if constexpr (std::is_arithmetic_v<typename T::value_type>)
+                readBytes(value.data(), value.size() * sizeof(typename T::value_type));
+            else
+            {
+                for (auto& element : value)
+                    read(element);
+            }
+        }
+        else if constexpr (IsMap<T>)
+        {
+            const size_t count = readCount();
+            for (size_t i = 0; i < count && !m_failed; ++i)
+            {
+                typename T::key_type key;
+                typename T::mapped_type mapped;
+                read(key);
+                read(mapped);
+                value.emplace(std::move(key), std::move(mapped));
+            }
+        }
+        else
+            serialize(*this, value);
+    }
+
+public:
+    template <typename T>
+    using Ref = T&;
+
+    explicit CacheReader(const std::span<const unsigned char> bytes) : m_bytes(bytes)
+    {
+    }
+
+    template <typename... T>
+    auto operator()(T&... values) -> void
+    {
+        (read(values), ...);
+    }
+
+    /**
+     * View of a CacheWriter::blob in the read bytes
+     */
+    auto blob() -> std::span<const unsigned char>
+    {
+        const size_t size = readCount();
+        const size_t aligned = (m_offset + CacheFile::BlobAlignment - 1) & ~(CacheFile::BlobAlignment - 1);
+        view(std::min(aligned, m_bytes.size()) - m_offset);
+        return view(size);
+    }
+
+    [[nodiscard]] auto failed() const -> bool { return m_failed; }
+
+    [[nodiscard]] auto finished() const -> bool { return !m_failed && m_offset == m_bytes.size(); }
+};
+
+#endif //CACHEFILE_H
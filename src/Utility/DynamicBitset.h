@@ -0,0 +1,59 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef DYNAMICBITSET_H
+#define DYNAMICBITSET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+class DynamicBitset
+{
+private:
+    static constexpr size_t WordBits = 64;
+
+    std::vector<uint64_t> m_words;
+
+public:
+    DynamicBitset() = default;
+
+    explicit DynamicBitset(const size_t count) : m_words((count + WordBits - 1) / WordBits, 0)
+    {
+    }
+
+    auto resize(const size_t count) -> void
+    {
+        m_words.resize((count + WordBits - 1) / WordBits, 0);
+    }
+
+    [[nodiscard]] auto test(const size_t index) const -> bool
+    {
+        return (m_words[index / WordBits] >> (index % WordBits)) & 1;
+    }
+
+    auto set(const size_t index) -> void
+    {
+        m_words[index / WordBits] |= uint64_t{1} << (index % WordBits);
+    }
+
+    auto reset() -> void
+    {
+        std::ranges::fill(m_words, 0);
+    }
+
+    [[nodiscard]] auto any() const -> bool
+    {
+        return std::ranges::any_of(m_words, [](const uint64_t word) { return word != 0; });
+    }
+
+    auto operator|=(const DynamicBitset& other) -> DynamicBitset&
+    {
+        for (size_t i = 0; i < std::min(m_words.size(), other.m_words.size()); ++i)
+            m_words[i] |= other.m_words[i];
+        return *this;
+    }
+};
+
+#endif //DYNAMICBITSET_H
@@ -0,0 +1,26 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint64_t Fnv1aOffset = 0xCBF29CE484222325ull;
+
+/**
+ * 64 bits FNV-1a, pass the previous result as hash to continue over several blocks
+ */
+inline auto fnv1a(const unsigned char* data, const size_t size, uint64_t hash = Fnv1aOffset) -> uint64_t
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#endif //HASH_H
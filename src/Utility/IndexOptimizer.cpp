@@ -0,0 +1,287 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "IndexOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    // A cluster ends on a triangle missing all its vertices once its own ACMR is this close to the mesh one, smaller
+    // clusters sort better but each cut costs cache misses
+    constexpr float ClusterAcmrThreshold = 1.05f;
+
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets; // Per vertex, in triangles
+        std::vector<uint32_t> triangles;
+    };
+
+    auto buildAdjacency(const std::vector<uint32_t>& indices, const size_t vertexCount) -> Adjacency
+    {
+        Adjacency adjacency;
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        for (const uint32_t index : indices)
+            ++adjacency.offsets[index + 1];
+        std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+        std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        adjacency.triangles.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency.triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+        return adjacency;
+    }
+}
+
+auto computeAcmr(const std::vector<uint32_t>& indices, const size_t vertexCount) -> float
+{
+    if (indices.empty())
+        return 0.0f;
+
+    // A vertex is cached while fewer than VertexCacheSize misses happened since its own
+    std::vector<size_t> missTime(vertexCount, 0);
+    size_t misses = 0;
+    for (const uint32_t index : indices)
+    {
+        if (missTime[index] == 0 || misses - missTime[index] >= VertexCacheSize)
+            missTime[index] = ++misses;
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+auto optimizeVertexCache(std::vector<uint32_t>& indices, const size_t vertexCount) -> std::vector<size_t>
+{
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<size_t> clusters;
+    if (triangleCount == 0)
+        return clusters;
+
+    const Adjacency adjacency = buildAdjacency(indices, vertexCount);
+
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    size_t time = VertexCacheSize + 1;
+    size_t cursor = 0;
+    int64_t fanning = indices[0];
+    bool reset = true;
+
+    while (fanning >= 0)
+    {
+        const auto vertex = static_cast<uint32_t>(fanning);
+        candidates.clear();
+
+        for (uint32_t a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; ++a)
+        {
+            const uint32_t triangle = adjacency.triangles[a];
+            if (emitted[triangle])
+                continue;
+
+            if (reset)
+            {
+                clusters.push_back(output.size() / 3);
+                reset = false;
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const uint32_t v = indices[triangle * 3 + i];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - cacheTime[v] > VertexCacheSize)
+                    cacheTime[v] = time++;
+            }
+            emitted[triangle] = 1;
+        }
+
+        // Next fanning vertex, the candidate that stays the longest in the cache while still having triangles
+        fanning = -1;
+        int64_t bestPriority = -1;
+        for (const uint32_t v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+                continue;
+
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= VertexCacheSize)
+                priority = static_cast<int64_t>(time - cacheTime[v]);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+
+        if (fanning >= 0)
+            continue;
+
+        // Dead end, restart from a recently used vertex, then from any vertex with triangles left
+        while (!deadEnd.empty())
+        {
+            const uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0)
+            {
+                fanning = v;
+                break;
+            }
+        }
+
+        if (fanning < 0)
+        {
+            while (cursor < vertexCount && liveTriangles[cursor] == 0)
+                ++cursor;
+            if (cursor < vertexCount)
+            {
+                fanning = static_cast<int64_t>(cursor);
+                reset = true;
+            }
+        }
+    }
+
+    indices = std::move(output);
+
+    // Split the clusters further on triangles missing all their vertices, once they are as good as the whole mesh
+    const float targetAcmr = computeAcmr(indices, vertexCount) * ClusterAcmrThreshold;
+    std::vector<size_t> splitClusters;
+    std::vector<size_t> missTime(vertexCount, 0);
+    size_t misses = 0;
+    size_t clusterMisses = 0;
+    size_t nextHardCluster = 0;
+    size_t clusterStart = 0;
+
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (nextHardCluster < clusters.size() && clusters[nextHardCluster] == t)
+        {
+            splitClusters.push_back(t);
+            clusterStart = t;
+            clusterMisses = 0;
+            ++nextHardCluster;
+        }
+
+        int triangleMisses = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            const uint32_t v = indices[t * 3 + i];
+            if (missTime[v] == 0 || misses - missTime[v] >= VertexCacheSize)
+            {
+                missTime[v] = ++misses;
+                ++triangleMisses;
+            }
+        }
+
+        const size_t clusterTriangles = t - clusterStart;
+        if (triangleMisses == 3 && clusterTriangles > 0 && splitClusters.back() != t &&
+            static_cast<float>(clusterMisses) <= targetAcmr * static_cast<float>(clusterTriangles))
+        {
+            splitClusters.push_back(t);
+            clusterStart = t;
+            clusterMisses = 0;
+        }
+        clusterMisses += triangleMisses;
+    }
+
+    return splitClusters;
+}
+
+auto optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+                      const std::vector<size_t>& clusters) -> void
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (clusters.size() < 2)
+        return;
+
+    glm::vec3 meshCenter{0.0f};
+    float meshArea = 0.0f;
+
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        glm::vec3 center{0.0f};
+        glm::vec3 normal{0.0f};
+        float sortKey{0.0f};
+    };
+
+    std::vector<Cluster> sortedClusters(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        Cluster& cluster = sortedClusters[c];
+        cluster.begin = clusters[c];
+        cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        float clusterArea = 0.0f;
+        for (size_t t = cluster.begin; t < cluster.end; ++t)
+        {
+            const glm::vec3& a = positions[indices[t * 3]];
+            const glm::vec3& b = positions[indices[t * 3 + 1]];
+            const glm::vec3& d = positions[indices[t * 3 + 2]];
+
+            // Area weighted, the normal length is twice the triangle area
+            const glm::vec3 normal = glm::cross(b - a, d - a);
+            const float area = glm::length(normal);
+            cluster.center += (a + b + d) * (area / 3.0f);
+            cluster.normal += normal;
+            clusterArea += area;
+        }
+
+        meshCenter += cluster.center;
+        meshArea += clusterArea;
+        if (clusterArea > 0.0f)
+            cluster.center /= clusterArea;
+    }
+    if (meshArea > 0.0f)
+        meshCenter /= meshArea;
+
+    // Clusters far from the centre in the direction they face are drawn first
+    for (auto& cluster : sortedClusters)
+    {
+        const float normalLength = glm::length(cluster.normal);
+        if (normalLength > 0.0f)
+            cluster.sortKey = glm::dot(cluster.center - meshCenter, cluster.normal / normalLength);
+    }
+    std::ranges::stable_sort(sortedClusters, std::greater<>(), &Cluster::sortKey);
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const auto& cluster : sortedClusters)
+        output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    indices = std::move(output);
+}
+
+auto optimizeVertexFetch(std::vector<uint32_t>& indices, const size_t vertexCount) -> std::vector<uint32_t>
+{
+    constexpr uint32_t Unassigned = ~0u;
+
+    std::vector<uint32_t> remap(vertexCount, Unassigned);
+    uint32_t next = 0;
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == Unassigned)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    for (uint32_t& newIndex : remap)
+    {
+        if (newIndex == Unassigned)
+            newIndex = next++;
+    }
+
+    return remap;
+}
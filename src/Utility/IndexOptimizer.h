@@ -0,0 +1,44 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef INDEXOPTIMIZER_H
+#define INDEXOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Reordering passes for indexed triangle lists, in the order they are meant to run: vertex cache, overdraw, then
+// vertex fetch. None of them changes the rendered triangles.
+
+constexpr size_t VertexCacheSize = 16; // Post transform cache simulated by the passes and the statistics
+
+/**
+ * Average cache miss ratio, vertex shader invocations per triangle with a FIFO cache of VertexCacheSize entries
+ */
+[[nodiscard]] auto computeAcmr(const std::vector<uint32_t>& indices, size_t vertexCount) -> float;
+
+/**
+ * Reorder the triangles for the post transform cache (Tipsify, Sander et al. 2007). Returns the index of the first
+ * triangle of each cluster, a cluster being a run of triangles starting on a cache reset that can be moved as a whole
+ * without hurting the cache much
+ */
+auto optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) -> std::vector<size_t>;
+
+/**
+ * Reorder the clusters returned by optimizeVertexCache so the ones facing outward from the mesh centre, likely to
+ * occlude the others, are drawn first
+ */
+auto optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+                      const std::vector<size_t>& clusters) -> void;
+
+/**
+ * Renumber the vertices in the order they are first used, so vertex fetches read memory linearly. Returns the new
+ * index of each vertex, unused vertices are moved to the end
+ */
+auto optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount) -> std::vector<uint32_t>;
+
+#endif //INDEXOPTIMIZER_H
@@ -0,0 +1,42 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+auto MappedFile::Open(const std::string& path) -> Expected<MappedFile, std::string>
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return Unexpected("Failed to open `" + path + "`: " + std::strerror(errno));
+
+    struct stat status{};
+    if (fstat(fd, &status) == -1 || status.st_size == 0)
+    {
+        close(fd);
+        return Unexpected("Failed to map `" + path + "`: empty or unreadable file");
+    }
+
+    // The mapping keeps its own reference to the file
+    const auto size = static_cast<size_t>(status.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    const int mapError = errno;
+    close(fd);
+    if (data == MAP_FAILED)
+        return Unexpected("Failed to map `" + path + "`: " + std::strerror(mapError));
+
+    return MappedFile(data, size);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+}
@@ -0,0 +1,60 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "Expected.h"
+
+/**
+ * Read only shared mapping of a whole file, its pages come from the page cache and are shared with every process
+ * mapping the same file
+ */
+class MappedFile
+{
+private:
+    void* m_data{nullptr};
+    size_t m_size{0};
+
+    MappedFile(void* data, const size_t size) : m_data(data), m_size(size)
+    {
+    }
+
+public:
+    static auto Open(const std::string& path) -> Expected<MappedFile, std::string>;
+
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    ~MappedFile();
+
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    auto operator=(MappedFile&& other) noexcept -> MappedFile&
+    {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+
+    [[nodiscard]] auto bytes() const -> std::span<const unsigned char>
+    {
+        return {static_cast<const unsigned char*>(m_data), m_size};
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return m_size; }
+};
+
+#endif //MAPPEDFILE_H
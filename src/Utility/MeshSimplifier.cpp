@@ -0,0 +1,389 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+    // Below this part of the previous level, a level stopped by the error limit is not worth its indices
+    constexpr float MinLevelReduction = 0.8f;
+
+    // Collapses turning a triangle by more than about 75 degrees are rejected, it would likely fold over its neighbours
+    constexpr float MinNormalCosine = 0.25f;
+
+    // Symmetric 4x4 matrix, sum of the squared distances to a set of planes
+    struct Quadric
+    {
+        double a2{0}, ab{0}, ac{0}, ad{0}, b2{0}, bc{0}, bd{0}, c2{0}, cd{0}, d2{0};
+
+        static auto FromPlane(const glm::vec3& normal, const float distance) -> Quadric
+        {
+            const double a = normal.x;
+            const double b = normal.y;
+            const double c = normal.z;
+            const double d = distance;
+            return {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+        }
+
+        auto operator+=(const Quadric& other) -> Quadric&
+        {
+            a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad; b2 += other.b2;
+            bc += other.bc; bd += other.bd; c2 += other.c2; cd += other.cd; d2 += other.d2;
+            return *this;
+        }
+
+        [[nodiscard]] auto evaluate(const glm::vec3& p) const -> double
+        {
+            const double x = p.x;
+            const double y = p.y;
+            const double z = p.z;
+            const double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                c2 * z * z + 2 * cd * z + d2;
+            return std::max(result, 0.0);
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromVersion;
+        uint32_t toVersion;
+
+        auto operator>(const Collapse& other) const -> bool { return cost > other.cost; }
+    };
+
+    auto triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) -> glm::vec3
+    {
+        return glm::cross(b - a, c - a);
+    }
+
+    class Simplifier
+    {
+    private:
+        const std::vector<glm::vec3>& m_positions;
+        std::vector<uint32_t> m_triangles; // Original vertex indices, remapped by collapses
+        std::vector<uint8_t> m_aliveTriangles;
+        size_t m_aliveCount{0};
+
+        // Indexed by original vertex, the welded vertex is the first one at the same position
+        std::vector<uint32_t> m_welded;
+
+        // Indexed by welded vertex
+        std::vector<Quadric> m_quadrics;
+        std::vector<std::vector<uint32_t>> m_vertexTriangles; // May contain dead triangles
+        std::vector<uint8_t> m_locked;
+        std::vector<uint8_t> m_removed;
+        std::vector<uint32_t> m_versions;
+
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> m_collapses;
+        std::vector<std::pair<uint32_t, uint32_t>> m_remap; // Scratch, vertex moved by a collapse and its target
+
+        auto weld() -> void;
+        auto initQuadrics() -> void;
+        auto lockBorders() -> void;
+        auto pushCollapse(uint32_t from, uint32_t to) -> void;
+        auto pushNeighbourCollapses(uint32_t vertex) -> void;
+        auto tryCollapse(uint32_t from, uint32_t to) -> bool;
+
+    public:
+        Simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+
+        auto run(std::span<const float> triangleRatios, float maxError) -> std::vector<SimplifiedLevel>;
+        auto snapshot() const -> std::vector<uint32_t>;
+    };
+
+    Simplifier::Simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+        : m_positions(positions), m_triangles(indices)
+    {
+        m_aliveCount = m_triangles.size() / 3;
+        m_aliveTriangles.resize(m_aliveCount, 1);
+
+        weld();
+        initQuadrics();
+        lockBorders();
+
+        for (uint32_t t = 0; t < m_aliveCount; ++t)
+        {
+            for (int i = 0; i < 3; ++i)
+                m_vertexTriangles[m_welded[m_triangles[t * 3 + i]]].push_back(t);
+        }
+
+        for (uint32_t t = 0; t < m_aliveCount; ++t)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                const uint32_t a = m_welded[m_triangles[t * 3 + i]];
+                const uint32_t b = m_welded[m_triangles[t * 3 + (i + 1) % 3]];
+                pushCollapse(a, b);
+                pushCollapse(b, a);
+            }
+        }
+    }
+
+    auto Simplifier::weld() -> void
+    {
+        struct PositionHash
+        {
+            auto operator()(const glm::vec3& p) const -> size_t
+            {
+                const auto x = std::bit_cast<uint32_t>(p.x);
+                const auto y = std::bit_cast<uint32_t>(p.y);
+                const auto z = std::bit_cast<uint32_t>(p.z);
+                return (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+            }
+        };
+
+        std::unordered_map<glm::vec3, uint32_t, PositionHash> firstVertex;
+        firstVertex.reserve(m_positions.size());
+
+        m_welded.resize(m_positions.size());
+        for (uint32_t v = 0; v < m_positions.size(); ++v)
+            m_welded[v] = firstVertex.try_emplace(m_positions[v], v).first->second;
+
+        m_quadrics.resize(m_positions.size());
+        m_vertexTriangles.resize(m_positions.size());
+        m_locked.resize(m_positions.size(), 0);
+        m_removed.resize(m_positions.size(), 0);
+        m_versions.resize(m_positions.size(), 0);
+    }
+
+    auto Simplifier::initQuadrics() -> void
+    {
+        for (size_t t = 0; t < m_aliveCount; ++t)
+        {
+            const glm::vec3& a = m_positions[m_triangles[t * 3]];
+            const glm::vec3& b = m_positions[m_triangles[t * 3 + 1]];
+            const glm::vec3& c = m_positions[m_triangles[t * 3 + 2]];
+
+            const glm::vec3 normal = triangleNormal(a, b, c);
+            const float length = glm::length(normal);
+            if (length <= 0.0f)
+                continue;
+
+            const glm::vec3 unitNormal = normal / length;
+            const Quadric quadric = Quadric::FromPlane(unitNormal, -glm::dot(unitNormal, a));
+            for (int i = 0; i < 3; ++i)
+                m_quadrics[m_welded[m_triangles[t * 3 + i]]] += quadric;
+        }
+    }
+
+    auto Simplifier::lockBorders() -> void
+    {
+        // An edge not shared by exactly two triangles is on a border or non manifold, moving its vertices would open
+        // holes
+        std::unordered_map<uint64_t, uint32_t> edgeTriangles;
+        edgeTriangles.reserve(m_triangles.size());
+        for (size_t t = 0; t < m_aliveCount; ++t)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                const uint32_t a = m_welded[m_triangles[t * 3 + i]];
+                const uint32_t b = m_welded[m_triangles[t * 3 + (i + 1) % 3]];
+                ++edgeTriangles[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)];
+            }
+        }
+
+        for (const auto& [edge, count] : edgeTriangles)
+        {
+            if (count != 2)
+            {
+                m_locked[edge >> 32] = 1;
+                m_locked[edge & 0xFFFFFFFFu] = 1;
+            }
+        }
+    }
+
+    auto Simplifier::pushCollapse(const uint32_t from, const uint32_t to) -> void
+    {
+        if (from == to || m_locked[from])
+            return;
+
+        Quadric quadric = m_quadrics[from];
+        quadric += m_quadrics[to];
+        m_collapses.push({quadric.evaluate(m_positions[to]), from, to, m_versions[from], m_versions[to]});
+    }
+
+    auto Simplifier::pushNeighbourCollapses(const uint32_t vertex) -> void
+    {
+        for (const uint32_t t : m_vertexTriangles[vertex])
+        {
+            if (!m_aliveTriangles[t])
+                continue;
+            for (int i = 0; i < 3; ++i)
+            {
+                const uint32_t neighbour = m_welded[m_triangles[t * 3 + i]];
+                pushCollapse(vertex, neighbour);
+                pushCollapse(neighbour, vertex);
+            }
+        }
+    }
+
+    auto Simplifier::tryCollapse(const uint32_t from, const uint32_t to) -> bool
+    {
+        // Each vertex at the removed position follows an edge to a vertex at the kept position, so it keeps its
+        // attributes on both sides of a seam. A vertex without such an edge can't move
+        m_remap.clear();
+        for (const uint32_t t : m_vertexTriangles[from])
+        {
+            if (!m_aliveTriangles[t])
+                continue;
+
+            const uint32_t* triangle = &m_triangles[t * 3];
+            for (int i = 0; i < 3; ++i)
+            {
+                if (m_welded[triangle[i]] != from)
+                    continue;
+                for (int j = 1; j < 3; ++j)
+                {
+                    const uint32_t other = triangle[(i + j) % 3];
+                    if (m_welded[other] == to &&
+                        std::ranges::find(m_remap, triangle[i], &std::pair<uint32_t, uint32_t>::first) ==
+                        m_remap.end())
+                        m_remap.emplace_back(triangle[i], other);
+                }
+            }
+        }
+
+        const glm::vec3& target = m_positions[to];
+        for (const uint32_t t : m_vertexTriangles[from])
+        {
+            if (!m_aliveTriangles[t])
+                continue;
+
+            const uint32_t* triangle = &m_triangles[t * 3];
+            bool hasTarget = false;
+            glm::vec3 corners[3];
+            glm::vec3 movedCorners[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                const uint32_t welded = m_welded[triangle[i]];
+                if (welded == from &&
+                    std::ranges::find(m_remap, triangle[i], &std::pair<uint32_t, uint32_t>::first) == m_remap.end())
+                    return false;
+
+                hasTarget |= welded == to;
+                corners[i] = m_positions[triangle[i]];
+                movedCorners[i] = welded == from ? target : corners[i];
+            }
+
+            // Triangles along the collapsed edge disappear, the others must not flip
+            if (hasTarget)
+                continue;
+            const glm::vec3 normal = triangleNormal(corners[0], corners[1], corners[2]);
+            const glm::vec3 movedNormal = triangleNormal(movedCorners[0], movedCorners[1], movedCorners[2]);
+            if (glm::dot(normal, movedNormal) <= MinNormalCosine * glm::length(normal) * glm::length(movedNormal))
+                return false;
+        }
+
+        for (const uint32_t t : m_vertexTriangles[from])
+        {
+            if (!m_aliveTriangles[t])
+                continue;
+
+            uint32_t* triangle = &m_triangles[t * 3];
+            bool hasTarget = false;
+            for (int i = 0; i < 3; ++i)
+            {
+                if (m_welded[triangle[i]] == from)
+                    triangle[i] = std::ranges::find(m_remap, triangle[i], &std::pair<uint32_t, uint32_t>::first)->
+                        second;
+                else
+                    hasTarget |= m_welded[triangle[i]] == to;
+            }
+
+            if (hasTarget)
+            {
+                m_aliveTriangles[t] = 0;
+                --m_aliveCount;
+            }
+            else
+                m_vertexTriangles[to].push_back(t);
+        }
+
+        // The removed vertices keep their welded index, they are no longer referenced by any alive triangle
+        m_quadrics[to] += m_quadrics[from];
+        m_removed[from] = 1;
+        m_vertexTriangles[from].clear();
+        ++m_versions[to];
+
+        // Keep the triangle list of the kept vertex compact
+        std::erase_if(m_vertexTriangles[to], [&](const uint32_t t) { return !m_aliveTriangles[t]; });
+
+        pushNeighbourCollapses(to);
+        return true;
+    }
+
+    auto Simplifier::run(const std::span<const float> triangleRatios, const float maxError)
+        -> std::vector<SimplifiedLevel>
+    {
+        std::vector<SimplifiedLevel> levels;
+
+        const size_t triangleCount = m_aliveCount;
+        const double maxCost = static_cast<double>(maxError) * maxError;
+        double reachedCost = 0.0;
+        size_t level = 0;
+
+        while (level < triangleRatios.size() && !m_collapses.empty())
+        {
+            const Collapse collapse = m_collapses.top();
+            m_collapses.pop();
+
+            if (m_removed[collapse.from] || m_removed[collapse.to] ||
+                m_versions[collapse.from] != collapse.fromVersion || m_versions[collapse.to] != collapse.toVersion)
+                continue;
+            if (collapse.cost > maxCost)
+                break;
+            if (!tryCollapse(collapse.from, collapse.to))
+                continue;
+
+            reachedCost = std::max(reachedCost, collapse.cost);
+            while (level < triangleRatios.size() &&
+                m_aliveCount <= static_cast<size_t>(static_cast<float>(triangleCount) * triangleRatios[level]))
+            {
+                levels.push_back({snapshot(), static_cast<float>(std::sqrt(reachedCost))});
+                ++level;
+            }
+        }
+
+        // Stopped before the target of the next level, still keep it when it removes enough triangles
+        const size_t previousCount = levels.empty() ? triangleCount : levels.back().indices.size() / 3;
+        if (level < triangleRatios.size() &&
+            static_cast<float>(m_aliveCount) <= static_cast<float>(previousCount) * MinLevelReduction)
+            levels.push_back({snapshot(), static_cast<float>(std::sqrt(reachedCost))});
+
+        return levels;
+    }
+
+    auto Simplifier::snapshot() const -> std::vector<uint32_t>
+    {
+        std::vector<uint32_t> indices;
+        indices.reserve(m_aliveCount * 3);
+        for (size_t t = 0; t < m_aliveTriangles.size(); ++t)
+        {
+            if (m_aliveTriangles[t])
+                indices.insert(indices.end(), m_triangles.begin() + t * 3, m_triangles.begin() + t * 3 + 3);
+        }
+        return indices;
+    }
+}
+
+auto simplifyMeshLevels(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                        const std::span<const float> triangleRatios, const float maxError)
+    -> std::vector<SimplifiedLevel>
+{
+    if (indices.size() < 3 || triangleRatios.empty())
+        return {};
+
+    Simplifier simplifier(positions, indices);
+    return simplifier.run(triangleRatios, maxError);
+}
@@ -0,0 +1,30 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+struct SimplifiedLevel
+{
+    std::vector<uint32_t> indices;
+    float error; // Approximate largest distance between the simplified and the original surface
+};
+
+/**
+ * Simplify an indexed triangle list with quadric error metrics, by collapsing vertices onto their neighbours so the
+ * vertex data can be shared by every level. Vertices sharing a position are moved together, and vertices on borders
+ * or attribute seams that can't follow an edge are kept.
+ * Returns one level per reached ratio of the original triangle count, in order, stopping once a collapse would cost
+ * more than maxError, the last level may then keep more triangles than its ratio
+ */
+auto simplifyMeshLevels(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                        std::span<const float> triangleRatios, float maxError) -> std::vector<SimplifiedLevel>;
+
+#endif //MESHSIMPLIFIER_H
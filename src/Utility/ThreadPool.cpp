@@ -0,0 +1,47 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+        m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+auto ThreadPool::work() -> void
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,111 @@
+//
+// Created by Simon Cros on 10/17/26.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed set of worker threads running submitted tasks in submission order
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{false};
+
+    auto work() -> void;
+
+public:
+    /**
+     * threadCount 0 uses one worker per hardware thread
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ~ThreadPool(); // Runs the remaining tasks before joining
+
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<F>>
+    {
+        // std::function must be copyable, the task is shared
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        {
+            std::lock_guard lock(m_mutex);
+            m_tasks.emplace_back([packaged] { (*packaged)(); });
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    /**
+     * Runs body(i) for i in [0, count) on the workers and the calling thread, and returns once every call returned.
+     * The caller takes indices too, so a task can call it without waiting on workers that may all be busy. body must
+     * not throw
+     */
+    template <typename F>
+    auto parallelFor(size_t count, F&& body) -> void
+    {
+        if (count == 0)
+            return;
+
+        // Shared, helpers may only start once the loop is over, they then find no index left and never touch body
+        struct Loop
+        {
+            std::atomic<size_t> next{0};
+            size_t done{0};
+            std::mutex mutex;
+            std::condition_variable condition;
+        };
+        auto loop = std::make_shared<Loop>();
+        auto run = [loop, count, &body]
+        {
+            size_t ran = 0;
+            for (size_t i = loop->next++; i < count; i = loop->next++, ++ran)
+                body(i);
+            if (ran == 0)
+                return;
+
+            std::lock_guard lock(loop->mutex);
+            loop->done += ran;
+            if (loop->done == count)
+                loop->condition.notify_one();
+        };
+
+        const size_t helpers = std::min(count - 1, m_workers.size());
+        {
+            std::lock_guard lock(m_mutex);
+            for (size_t i = 0; i < helpers; ++i)
+                m_tasks.emplace_back(run);
+        }
+        m_condition.notify_all();
+
+        run();
+        std::unique_lock lock(loop->mutex);
+        loop->condition.wait(lock, [&] { return loop->done == count; });
+    }
+
+    [[nodiscard]] auto threadCount() const -> size_t { return m_workers.size(); }
+};
+
+#endif //THREADPOOL_H
@@ -5,6 +5,7 @@
 
 #include "HumanGLConfig.h"
 #include "Engine/Engine.h"
+#include "Engine/ModelLoad.h"
 #include "Window/Window.h"
 #include "WindowContext.h"
 #include "Components/UserInterface.h"
@@ -14,6 +15,7 @@
 #include "InterfaceBlocks/CameraTargetInterfaceBlock.h"
 #include "InterfaceBlocks/DisplayInterfaceBlock.h"
 #include "InterfaceBlocks/GolemInterfaceBlock.h"
+#include "InterfaceBlocks/RenderStatsInterfaceBlock.h"
 
 auto start() -> Expected<void, std::string>
 {
@@ -35,13 +37,33 @@ auto start() -> Expected<void, std::string>
     if (!e_shader)
         return Unexpected("Failed to load model: " + std::move(e_shader).error());
 
-    auto e_frogMesh = engine.loadModel("frog", RESOURCE_PATH"models/frog_jumping/scene.gltf", false);
+    auto e_occlusionCulling = engine.initOcclusionCulling(RESOURCE_PATH"shaders/bounds.vert",
+                                                          RESOURCE_PATH"shaders/bounds.frag");
+    if (!e_occlusionCulling)
+        return Unexpected("Failed to init occlusion culling: " + std::move(e_occlusionCulling).error());
+
+    // Cooked after the first launch, the import passes only run again when a source file changes, and the buffers
+    // of a cooked model are read in place from the cache
+    constexpr MeshOptions modelOptions{
+        .generateLods = true, .optimizeIndices = true, .quantizeAttributes = true, .cook = true, .mapBuffers = true,
+        .streamTextures = true
+    };
+    auto villageOptions = modelOptions;
+    villageOptions.mergeBuffers = true;
+
+    // Prepared concurrently on the engine workers, only the GL uploads run here
+    auto frogLoad = engine.loadModelAsync("frog", RESOURCE_PATH"models/frog_jumping/scene.gltf", false, modelOptions);
+    auto golemLoad = engine.loadModelAsync("golem", RESOURCE_PATH"models/iron_golem/scene.gltf", false, modelOptions);
+    auto villageLoad = engine.loadModelAsync("village", RESOURCE_PATH"models/minecraft_village/scene.gltf", false,
+                                             villageOptions);
+
+    auto e_frogMesh = engine.finishModelLoad(std::move(frogLoad));
     if (!e_frogMesh)
         return Unexpected("Failed to load model: " + std::move(e_frogMesh).error());
-    auto e_golemMesh = engine.loadModel("golem", RESOURCE_PATH"models/iron_golem/scene.gltf", false);
+    auto e_golemMesh = engine.finishModelLoad(std::move(golemLoad));
     if (!e_golemMesh)
         return Unexpected("Failed to load model: " + std::move(e_golemMesh).error());
-    auto e_villageMesh = engine.loadModel("village", RESOURCE_PATH"models/minecraft_village/scene.gltf", false);
+    auto e_villageMesh = engine.finishModelLoad(std::move(villageLoad));
     if (!e_villageMesh)
         return Unexpected("Failed to load model: " + std::move(e_villageMesh).error());
 
@@ -68,6 +90,7 @@ auto start() -> Expected<void, std::string>
         auto& animator = object.addComponent<Animator>(*e_frogMesh);
         auto& meshRenderer = object.addComponent<MeshRenderer>(*e_frogMesh, *e_shader);
         meshRenderer.setAnimator(animator);
+        meshRenderer.setInstanced(true);
         animator.setAnimation(0);
         constexpr auto windowData = ImguiWindowData{
             .s_frame_x = WIDTH - 8 - 230, .s_frame_y = 8, .s_frame_width = 230, .s_frame_height = 125
@@ -85,6 +108,7 @@ auto start() -> Expected<void, std::string>
         auto& animator = object.addComponent<Animator>(*e_frogMesh);
         auto& meshRenderer = object.addComponent<MeshRenderer>(*e_frogMesh, *e_shader);
         meshRenderer.setAnimator(animator);
+        meshRenderer.setInstanced(true);
         animator.setAnimation(0);
         constexpr auto windowData = ImguiWindowData{
             .s_frame_x = WIDTH - 8 - 230, .s_frame_y = 8 + 125 + 8, .s_frame_width = 230, .s_frame_height = 125
@@ -103,6 +127,7 @@ auto start() -> Expected<void, std::string>
         auto& animator = object.addComponent<Animator>(*e_frogMesh);
         auto& meshRenderer = object.addComponent<MeshRenderer>(*e_frogMesh, *e_shader);
         meshRenderer.setAnimator(animator);
+        meshRenderer.setInstanced(true);
         animator.setAnimation(0);
         constexpr auto windowData = ImguiWindowData{
             .s_frame_x = WIDTH - 8 - 230, .s_frame_y = 8 + 125 + 8 + 125 + 8, .s_frame_width = 230,
@@ -121,7 +146,7 @@ auto start() -> Expected<void, std::string>
         meshRenderer.setAnimator(animator);
         animator.setAnimation(7);
         constexpr auto windowData = ImguiWindowData{
-            .s_frame_x = 8, .s_frame_y = 8 + 125 + 8, .s_frame_width = 230, .s_frame_height = 400
+            .s_frame_x = 8, .s_frame_y = 8 + 290 + 8, .s_frame_width = 230, .s_frame_height = 400
         };
         auto& interface = object.addComponent<UserInterface>("Golem", windowData);
         interface.addBlock<CameraTargetInterfaceBlock>(1, *cameraController, 5);
@@ -132,16 +157,18 @@ auto start() -> Expected<void, std::string>
     {
         // Village
         auto& object = engine.instantiate();
-        object.addComponent<MeshRenderer>(*e_villageMesh, *e_shader);
+        auto& meshRenderer = object.addComponent<MeshRenderer>(*e_villageMesh, *e_shader);
+        meshRenderer.setOcclusionCulled(true);
         object.transform().translation = glm::vec3(-4.2, 8.11, -4);
         object.transform().scale = glm::vec3(1.5f);
         constexpr auto windowData = ImguiWindowData{
             .s_frame_x = 8, .s_frame_y = 8, .s_frame_width = 230,
-            .s_frame_height = 125
+            .s_frame_height = 290
         };
         auto& interface = object.addComponent<UserInterface>("Village", windowData);
         interface.addBlock<CameraTargetInterfaceBlock>(1, *cameraController, 20);
         interface.addBlock<DisplayInterfaceBlock>(10);
+        interface.addBlock<RenderStatsInterfaceBlock>(20);
     }
 
     engine.run();
@@ -0,0 +1,165 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// Compares the batch sampling of AnimationSampler against its per-time sampling, which uses a binary search and
+// glm::mix / glm::slerp. Built once per kernel path of Utility/BatchInterpolation, see tests/CMakeLists.txt.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Engine/AnimationSampler.h"
+
+struct Track
+{
+    std::vector<float> times;
+    std::vector<glm::vec3> translations;
+    std::vector<float> rotations; // x, y, z, w per key, like a glTF buffer
+};
+
+static auto randomQuat(std::mt19937& random) -> glm::vec4
+{
+    std::normal_distribution<float> normal;
+    glm::vec4 q(normal(random), normal(random), normal(random), normal(random));
+    const float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return glm::vec4(q.x / length, q.y / length, q.z / length, q.w / length);
+}
+
+static auto makeTrack(std::mt19937& random, const std::vector<float>& times) -> Track
+{
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+
+    Track track;
+    track.times = times;
+    glm::vec4 previous{};
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        track.translations.emplace_back(position(random), position(random), position(random));
+
+        glm::vec4 q = randomQuat(random);
+        if (i == 2)
+            q = previous; // Identical keys take the linear fallback of slerp
+        else if (i == 3 && previous.x * q.x + previous.y * q.y + previous.z * q.z + previous.w * q.w > 0)
+            q = glm::vec4(-q.x, -q.y, -q.z, -q.w); // Opposite hemispheres take the shortest path
+        track.rotations.insert(track.rotations.end(), {q.x, q.y, q.z, q.w});
+        previous = q;
+    }
+    return track;
+}
+
+static auto quatDistance(const glm::quat& a, const glm::quat& b) -> float
+{
+    // q and -q are the same rotation, compare against the closest
+    float same = 0;
+    float opposite = 0;
+    for (int c = 0; c < 4; ++c)
+    {
+        same = std::max(same, std::abs(a[c] - b[c]));
+        opposite = std::max(opposite, std::abs(a[c] + b[c]));
+    }
+    return std::min(same, opposite);
+}
+
+static auto checkBatch(const AnimationSampler& translations, const AnimationSampler& rotations,
+                       const std::vector<float>& times, std::vector<size_t>& cursors, const std::string& label) -> void
+{
+    const size_t count = times.size();
+    std::vector<glm::vec3> vec3s(count);
+    std::vector<glm::quat> slerps(count);
+    std::vector<glm::quat> nlerps(count);
+
+    // Each call gets its own copy of the cursors, they must all reach the same keys
+    auto vec3Cursors = cursors;
+    auto nlerpCursors = cursors;
+    translations.vec3Batch(times, vec3Cursors, vec3s);
+    rotations.quatBatch(times, cursors, slerps, QuatBlend::Slerp);
+    rotations.quatBatch(times, nlerpCursors, nlerps, QuatBlend::Nlerp);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto where = label + " at time " + std::to_string(times[i]);
+
+        const glm::vec3 expectedVec3 = translations.vec3(times[i]);
+        for (int c = 0; c < 3; ++c)
+            check(std::abs(vec3s[i][c] - expectedVec3[c]) <= 1e-5f * (1.0f + std::abs(expectedVec3[c])),
+                  "vec3Batch differs from vec3 " + where);
+
+        const glm::quat expectedQuat = rotations.quat(times[i]);
+        check(quatDistance(slerps[i], expectedQuat) <= 1e-4f, "quatBatch slerp differs from quat " + where);
+
+        const auto& nlerp = nlerps[i];
+        const float length = std::sqrt(nlerp.x * nlerp.x + nlerp.y * nlerp.y + nlerp.z * nlerp.z + nlerp.w * nlerp.w);
+        check(std::abs(length - 1.0f) <= 1e-5f, "quatBatch nlerp is not normalized " + where);
+        // Nlerp drifts from slerp by at most about 4 degrees of quaternion angle between keys 90 degrees apart
+        const float dot = nlerp.x * expectedQuat.x + nlerp.y * expectedQuat.y + nlerp.z * expectedQuat.z +
+            nlerp.w * expectedQuat.w;
+        check(std::abs(dot) >= 0.995f, "quatBatch nlerp is far from quat " + where);
+    }
+}
+
+static auto testTrack(std::mt19937& random, const std::vector<float>& keyTimes, const std::string& label) -> void
+{
+    const Track track = makeTrack(random, keyTimes);
+    const AnimationSampler translations({track.times.size(), 1, track.times.data()},
+                                        {track.translations.size(), sizeof(glm::vec3),
+                                         reinterpret_cast<const GLubyte*>(track.translations.data())});
+    const AnimationSampler rotations({track.times.size(), 1, track.times.data()},
+                                     {track.times.size(), 4 * sizeof(float),
+                                      reinterpret_cast<const GLubyte*>(track.rotations.data())});
+
+    const float first = keyTimes.front();
+    const float last = keyTimes.back();
+    const float length = std::max(last - first, 1.0f); // Playbacks of a single key still wrap
+    std::uniform_real_distribution<float> anyTime(first - 0.5f, last + 0.5f);
+
+    // Sizes around the SIMD widths and the stack block of the batch functions
+    for (const size_t count : {1, 3, 4, 7, 8, 9, 64, 197})
+    {
+        std::vector<float> times(count);
+        std::vector<size_t> cursors(count, 0);
+
+        // Random times, outside of the key range too, with fresh then stale cursors
+        for (auto& time : times)
+            time = anyTime(random);
+        checkBatch(translations, rotations, times, cursors, label + " random");
+        for (auto& time : times)
+            time = anyTime(random);
+        checkBatch(translations, rotations, times, cursors, label + " random with stale cursors");
+
+        // Exact keys, and the first and last key
+        for (size_t i = 0; i < count; ++i)
+            times[i] = keyTimes[i % keyTimes.size()];
+        checkBatch(translations, rotations, times, cursors, label + " on keys");
+
+        // Monotonic playbacks with their cursors kept between frames, wrapping like Animator does
+        std::ranges::fill(cursors, 0);
+        for (size_t i = 0; i < count; ++i)
+            times[i] = first + length * static_cast<float>(i) / static_cast<float>(count);
+        for (int frame = 0; frame < 40; ++frame)
+        {
+            checkBatch(translations, rotations, times, cursors, label + " playback");
+            for (auto& time : times)
+                time = first + std::fmod(time - first + 0.037f, length);
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 random(42);
+
+    testTrack(random, {0.0f, 0.1f, 0.35f, 0.4f, 0.9f, 1.0f, 1.75f, 2.0f, 2.1f, 3.0f}, "track");
+    testTrack(random, {0.5f, 1.5f}, "two keys");
+    testTrack(random, {0.25f}, "single key");
+
+    std::vector<float> manyKeys;
+    for (int i = 0; i < 300; ++i)
+        manyKeys.push_back(static_cast<float>(i) * 0.04f + (i % 3 == 0 ? 0.01f : 0.0f));
+    testTrack(random, manyKeys, "many keys");
+
+    return checkResult();
+}
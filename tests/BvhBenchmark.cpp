@@ -0,0 +1,240 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// Build, refit, frustum and ray query times of the Bvh, with every query checked against a brute force scan
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Engine/Bvh.h"
+
+// The tree only stores object pointers, the benchmark doesn't need the engine objects behind them
+class Object
+{
+};
+
+namespace
+{
+    constexpr size_t ProxyCounts[] = {10'000, 50'000, 100'000};
+    constexpr int FrustumCount = 100;
+    constexpr int RayCount = 1'000;
+    constexpr int RefitCount = 10;
+    constexpr float WorldSize = 1000.0f;
+
+    using Clock = std::chrono::steady_clock;
+
+    auto milliseconds(const Clock::duration duration) -> double
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    struct Scene
+    {
+        std::vector<Object> objects;
+        std::vector<AABB> bounds;
+        std::vector<Bvh::ProxyId> proxies;
+    };
+
+    auto randomBox(std::mt19937& random) -> AABB
+    {
+        std::uniform_real_distribution<float> position(-WorldSize * 0.5f, WorldSize * 0.5f);
+        std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+        const glm::vec3 center(position(random), position(random), position(random));
+        const glm::vec3 extent(size(random), size(random), size(random));
+        return {.min = center - extent, .max = center + extent};
+    }
+
+    /**
+     * Perspective frustum at eye looking along direction on the horizontal plane, built from its planes
+     */
+    auto makeFrustum(const glm::vec3& eye, const float yaw, const float halfFov, const float far) -> Frustum
+    {
+        const glm::vec3 forward(std::sin(yaw), 0.0f, -std::cos(yaw));
+        const glm::vec3 right(std::cos(yaw), 0.0f, std::sin(yaw));
+        const glm::vec3 up(0.0f, 1.0f, 0.0f);
+        const float tangent = std::tan(halfFov);
+
+        const glm::vec3 normals[] = {
+            right + forward * tangent, // Left
+            forward * tangent - right, // Right
+            up + forward * tangent, // Bottom
+            forward * tangent - up, // Top
+            forward, // Near
+            -forward, // Far
+        };
+        const float offsets[] = {0.0f, 0.0f, 0.0f, 0.0f, -0.1f, far};
+
+        Frustum frustum;
+        for (size_t i = 0; i < frustum.planes.size(); ++i)
+            frustum.planes[i] = glm::vec4(normals[i], offsets[i] - glm::dot(normals[i], eye));
+        return frustum;
+    }
+
+    auto randomDirection(std::mt19937& random) -> glm::vec3
+    {
+        std::normal_distribution<float> normal;
+        glm::vec3 direction;
+        do
+            direction = glm::vec3(normal(random), normal(random), normal(random));
+        while (glm::dot(direction, direction) < 1e-6f);
+        return direction / std::sqrt(glm::dot(direction, direction));
+    }
+
+    struct QueryTimes
+    {
+        Clock::duration frustum{};
+        Clock::duration bruteFrustum{};
+        Clock::duration ray{};
+        Clock::duration bruteRay{};
+        size_t visited{0};
+        size_t hits{0};
+    };
+
+    auto checkQueries(const Bvh& bvh, const Scene& scene, std::mt19937& random, const std::string& label)
+        -> QueryTimes
+    {
+        QueryTimes times;
+        std::uniform_real_distribution<float> position(-WorldSize * 0.5f, WorldSize * 0.5f);
+        std::uniform_real_distribution<float> angle(0.0f, 2.0f * std::numbers::pi_v<float>);
+
+        std::vector<const Object*> found;
+        std::vector<const Object*> expected;
+        for (int i = 0; i < FrustumCount; ++i)
+        {
+            const Frustum frustum = makeFrustum({position(random), position(random), position(random)}, angle(random),
+                                                std::numbers::pi_v<float> / 6.0f, WorldSize * 0.25f);
+            found.clear();
+            expected.clear();
+
+            auto start = Clock::now();
+            bvh.queryFrustum(frustum, [&](const Object& object) { found.push_back(&object); });
+            times.frustum += Clock::now() - start;
+
+            start = Clock::now();
+            for (size_t p = 0; p < scene.proxies.size(); ++p)
+            {
+                if (frustum.intersects(scene.bounds[p]))
+                    expected.push_back(&scene.objects[p]);
+            }
+            times.bruteFrustum += Clock::now() - start;
+
+            std::ranges::sort(found);
+            std::ranges::sort(expected);
+            check(found == expected, label + ": frustum " + std::to_string(i) + " found " +
+                  std::to_string(found.size()) + " objects, brute force " + std::to_string(expected.size()));
+            times.visited += found.size();
+        }
+
+        for (int i = 0; i < RayCount; ++i)
+        {
+            const Ray ray{.origin = {position(random), position(random), position(random)},
+                          .direction = randomDirection(random)};
+
+            auto start = Clock::now();
+            const auto hit = bvh.raycast(ray);
+            times.ray += Clock::now() - start;
+
+            start = Clock::now();
+            std::optional<float> closest;
+            for (size_t p = 0; p < scene.proxies.size(); ++p)
+            {
+                const auto distance = ray.intersects(scene.bounds[p], std::numeric_limits<float>::max());
+                if (distance && (!closest || *distance < *closest))
+                    closest = distance;
+            }
+            times.bruteRay += Clock::now() - start;
+
+            // Ties may report another object, the distances must match
+            check(hit.has_value() == closest.has_value() && (!hit || hit->distance == *closest),
+                  label + ": ray " + std::to_string(i) + " hit " + (hit ? std::to_string(hit->distance) : "nothing") +
+                  ", brute force " + (closest ? std::to_string(*closest) : "nothing"));
+            times.hits += hit.has_value();
+        }
+
+        return times;
+    }
+
+    auto printQueries(const char* label, const QueryTimes& times) -> void
+    {
+        std::printf("  %-8s frustum %8.3f ms (brute force %8.3f ms, %zu visits)  ray %8.3f us (brute force %8.3f us,"
+                    " %zu hits)\n", label, milliseconds(times.frustum) / FrustumCount,
+                    milliseconds(times.bruteFrustum) / FrustumCount, times.visited / FrustumCount,
+                    milliseconds(times.ray) / RayCount * 1000.0, milliseconds(times.bruteRay) / RayCount * 1000.0,
+                    times.hits);
+    }
+
+    auto benchmark(const size_t proxyCount) -> void
+    {
+        std::mt19937 random(static_cast<std::mt19937::result_type>(proxyCount));
+        Scene scene;
+        scene.objects.resize(proxyCount);
+        scene.bounds.reserve(proxyCount);
+        scene.proxies.reserve(proxyCount);
+
+        Bvh bvh;
+        for (size_t i = 0; i < proxyCount; ++i)
+        {
+            scene.bounds.push_back(randomBox(random));
+            scene.proxies.push_back(bvh.createProxy(scene.bounds.back(), scene.objects[i]));
+        }
+
+        auto start = Clock::now();
+        bvh.update();
+        const auto build = Clock::now() - start;
+
+        const std::string label = std::to_string(proxyCount) + " proxies";
+        check(bvh.proxyCount() == proxyCount, label + ": proxy count");
+        std::printf("%zu proxies, %zu nodes\n  build %.3f ms\n", proxyCount, bvh.nodeCount(), milliseconds(build));
+        printQueries("built", checkQueries(bvh, scene, random, label + " built"));
+
+        // Every proxy moves a little each frame, only the boxes of the tree are refit
+        std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+        Clock::duration refit{};
+        for (int frame = 0; frame < RefitCount; ++frame)
+        {
+            for (size_t i = 0; i < proxyCount; ++i)
+            {
+                const glm::vec3 offset(jitter(random), jitter(random), jitter(random));
+                scene.bounds[i] = {.min = scene.bounds[i].min + offset, .max = scene.bounds[i].max + offset};
+                bvh.moveProxy(scene.proxies[i], scene.bounds[i]);
+            }
+
+            start = Clock::now();
+            bvh.update();
+            refit += Clock::now() - start;
+        }
+        std::printf("  refit %.3f ms\n", milliseconds(refit) / RefitCount);
+        printQueries("refit", checkQueries(bvh, scene, random, label + " refit"));
+
+        // Replacing a tenth of the proxies rebuilds the tree, freed proxy ids are reused
+        for (size_t i = 0; i < proxyCount; i += 10)
+        {
+            bvh.destroyProxy(scene.proxies[i]);
+            scene.bounds[i] = randomBox(random);
+            scene.proxies[i] = bvh.createProxy(scene.bounds[i], scene.objects[i]);
+        }
+        start = Clock::now();
+        bvh.update();
+        std::printf("  rebuild %.3f ms\n", milliseconds(Clock::now() - start));
+        check(bvh.proxyCount() == proxyCount, label + ": proxy count after rebuild");
+        printQueries("rebuilt", checkQueries(bvh, scene, random, label + " rebuilt"));
+    }
+}
+
+int main()
+{
+    for (const size_t proxyCount : ProxyCounts)
+        benchmark(proxyCount);
+    return checkResult();
+}
@@ -0,0 +1,36 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+#include <source_location>
+#include <string_view>
+
+// Minimal assertions for the test executables, which return checkResult() from main so CTest sees the failures.
+
+inline int g_checkFailures = 0;
+
+inline auto check(const bool condition, const std::string_view message,
+                  const std::source_location location = std::source_location::current()) -> bool
+{
+    if (!condition)
+    {
+        // Only the first failures are printed, a broken kernel fails thousands of samples
+        if (g_checkFailures < 20)
+            std::cerr << location.file_name() << ":" << location.line() << ": " << message << std::endl;
+        ++g_checkFailures;
+    }
+    return condition;
+}
+
+inline auto checkResult() -> int
+{
+    if (g_checkFailures > 0)
+        std::cerr << g_checkFailures << " checks failed" << std::endl;
+    return g_checkFailures == 0 ? 0 : 1;
+}
+
+#endif //CHECK_H
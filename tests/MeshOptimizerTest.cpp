@@ -0,0 +1,341 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// The index optimizer passes only reorder triangles and vertices, and MeshOptimizer leaves alone the vertex data it
+// can't renumber safely
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Check.h"
+#include "Engine/MeshOptimizer.h"
+#include "Utility/IndexOptimizer.h"
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    /**
+     * Rotated to start with its smallest index, which keeps the winding
+     */
+    auto canonical(const uint32_t a, const uint32_t b, const uint32_t c) -> Triangle
+    {
+        if (a <= b && a <= c)
+            return {a, b, c};
+        if (b <= a && b <= c)
+            return {b, c, a};
+        return {c, a, b};
+    }
+
+    auto triangles(const std::vector<uint32_t>& indices) -> std::vector<Triangle>
+    {
+        std::vector<Triangle> result;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            result.push_back(canonical(indices[i], indices[i + 1], indices[i + 2]));
+        std::ranges::sort(result);
+        return result;
+    }
+
+    struct Grid
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
+
+    /**
+     * size x size quads on a bumpy surface, triangles shuffled so the caches start cold
+     */
+    auto makeGrid(const uint32_t size, const uint32_t seed) -> Grid
+    {
+        Grid grid;
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+                grid.positions.emplace_back(x, y, std::sin(x * 0.7f) * std::cos(y * 0.4f));
+        }
+
+        std::vector<Triangle> quads;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const uint32_t v = y * (size + 1) + x;
+                quads.push_back({v, v + 1, v + size + 2});
+                quads.push_back({v, v + size + 2, v + size + 1});
+            }
+        }
+
+        std::mt19937 random(seed);
+        std::ranges::shuffle(quads, random);
+        for (const auto& triangle : quads)
+            grid.indices.insert(grid.indices.end(), triangle.begin(), triangle.end());
+        return grid;
+    }
+
+    auto testIndexPasses(const uint32_t size, const uint32_t seed) -> void
+    {
+        const std::string label = std::to_string(size) + "x" + std::to_string(size) + " grid";
+        auto grid = makeGrid(size, seed);
+        const size_t vertexCount = grid.positions.size() + 5; // A few unused vertices
+        grid.positions.resize(vertexCount, glm::vec3(0.0f));
+        const auto source = triangles(grid.indices);
+        const float acmrBefore = computeAcmr(grid.indices, vertexCount);
+
+        auto indices = grid.indices;
+        const auto clusters = optimizeVertexCache(indices, vertexCount);
+        check(triangles(indices) == source, label + ": optimizeVertexCache changed the triangles");
+        check(!clusters.empty() && clusters.front() == 0 && std::ranges::is_sorted(clusters) &&
+              clusters.back() < indices.size() / 3, label + ": clusters are not sorted triangle indices");
+
+        optimizeOverdraw(indices, grid.positions, clusters);
+        check(triangles(indices) == source, label + ": optimizeOverdraw changed the triangles");
+
+        const float acmrAfter = computeAcmr(indices, vertexCount);
+        check(acmrAfter <= acmrBefore, label + ": ACMR " + std::to_string(acmrBefore) + " -> " +
+              std::to_string(acmrAfter));
+
+        const auto beforeFetch = indices;
+        const auto remap = optimizeVertexFetch(indices, vertexCount);
+        std::vector<uint32_t> sorted = remap;
+        std::ranges::sort(sorted);
+        std::vector<uint32_t> identity(vertexCount);
+        std::iota(identity.begin(), identity.end(), 0u);
+        check(sorted == identity, label + ": optimizeVertexFetch remap is not a permutation");
+
+        bool remapped = remap.size() == vertexCount;
+        uint32_t nextNew = 0;
+        for (size_t i = 0; remapped && i < indices.size(); ++i)
+        {
+            remapped &= indices[i] == remap[beforeFetch[i]];
+            if (indices[i] == nextNew)
+                ++nextNew;
+            remapped &= indices[i] < nextNew; // First uses are numbered in order
+        }
+        check(remapped, label + ": indices are not renumbered by first use");
+        for (size_t v = grid.positions.size() - 5; v < vertexCount; ++v)
+            check(remap[v] >= vertexCount - 5, label + ": unused vertex not moved to the end");
+    }
+
+    /**
+     * Model whose buffer holds the views added in order, each 4 bytes aligned
+     */
+    struct TestModel
+    {
+        tinygltf::Model model;
+
+        TestModel()
+        {
+            model.buffers.emplace_back();
+            model.meshes.emplace_back();
+        }
+
+        auto addView(const void* data, const size_t size, const size_t stride = 0) -> int
+        {
+            auto& bytes = model.buffers[0].data;
+            tinygltf::BufferView view;
+            view.buffer = 0;
+            view.byteOffset = (bytes.size() + 3) & ~size_t{3};
+            view.byteLength = size;
+            view.byteStride = stride;
+            bytes.resize(view.byteOffset + size);
+            std::memcpy(bytes.data() + view.byteOffset, data, size);
+            model.bufferViews.push_back(view);
+            return static_cast<int>(model.bufferViews.size()) - 1;
+        }
+
+        auto addAccessor(const int view, const size_t byteOffset, const int componentType, const int type,
+                         const size_t count) -> int
+        {
+            tinygltf::Accessor accessor;
+            accessor.bufferView = view;
+            accessor.byteOffset = byteOffset;
+            accessor.componentType = componentType;
+            accessor.type = type;
+            accessor.count = count;
+            model.accessors.push_back(accessor);
+            return static_cast<int>(model.accessors.size()) - 1;
+        }
+
+        auto addIndices(const std::vector<uint32_t>& indices) -> int
+        {
+            const int view = addView(indices.data(), indices.size() * sizeof(uint32_t));
+            return addAccessor(view, 0, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR, indices.size());
+        }
+
+        auto addPrimitive(const int indices, const std::map<std::string, int>& attributes) -> void
+        {
+            tinygltf::Primitive primitive;
+            primitive.mode = TINYGLTF_MODE_TRIANGLES;
+            primitive.indices = indices;
+            primitive.attributes = attributes;
+            model.meshes[0].primitives.push_back(primitive);
+        }
+
+        [[nodiscard]] auto viewBytes(const int view) const -> std::vector<unsigned char>
+        {
+            const auto& bufferView = model.bufferViews[view];
+            const auto begin = model.buffers[0].data.begin() + static_cast<std::ptrdiff_t>(bufferView.byteOffset);
+            return {begin, begin + static_cast<std::ptrdiff_t>(bufferView.byteLength)};
+        }
+
+        [[nodiscard]] auto indices(const int accessor) const -> std::vector<uint32_t>
+        {
+            const auto bytes = viewBytes(model.accessors[accessor].bufferView);
+            std::vector<uint32_t> result(model.accessors[accessor].count);
+            std::memcpy(result.data(), bytes.data(), result.size() * sizeof(uint32_t));
+            return result;
+        }
+
+        [[nodiscard]] auto position(const int accessor, const uint32_t vertex) const -> glm::vec3
+        {
+            const auto& bufferView = model.bufferViews[model.accessors[accessor].bufferView];
+            const size_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : sizeof(glm::vec3);
+            glm::vec3 position;
+            std::memcpy(&position, model.buffers[0].data.data() + bufferView.byteOffset +
+                        model.accessors[accessor].byteOffset + vertex * stride, sizeof(position));
+            return position;
+        }
+
+        /**
+         * Triangles as positions, comparable across a vertex renumbering
+         */
+        [[nodiscard]] auto positionTriangles(const int indexAccessor, const int positionAccessor) const
+            -> std::vector<std::array<float, 9>>
+        {
+            std::vector<std::array<float, 9>> result;
+            const auto indexList = indices(indexAccessor);
+            for (size_t i = 0; i + 2 < indexList.size(); i += 3)
+            {
+                std::array<glm::vec3, 3> corners{};
+                for (size_t c = 0; c < 3; ++c)
+                    corners[c] = position(positionAccessor, indexList[i + c]);
+                const auto less = [](const glm::vec3& a, const glm::vec3& b)
+                {
+                    return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+                };
+                const size_t first = less(corners[1], corners[0])
+                                         ? (less(corners[2], corners[1]) ? 2 : 1)
+                                         : (less(corners[2], corners[0]) ? 2 : 0);
+
+                std::array<float, 9> triangle{};
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    const glm::vec3& corner = corners[(first + c) % 3];
+                    triangle[c * 3] = corner.x;
+                    triangle[c * 3 + 1] = corner.y;
+                    triangle[c * 3 + 2] = corner.z;
+                }
+                result.push_back(triangle);
+            }
+            std::ranges::sort(result);
+            return result;
+        }
+    };
+
+    // Own position and normal accessors, the vertices are renumbered
+    auto testOwnedAccessors() -> void
+    {
+        const auto grid = makeGrid(12, 1);
+        const std::vector<glm::vec3> normals(grid.positions.size(), glm::vec3(0.0f, 0.0f, 1.0f));
+
+        TestModel test;
+        const int positions = test.addAccessor(test.addView(grid.positions.data(),
+                                                            grid.positions.size() * sizeof(glm::vec3)),
+                                               0, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+                                               grid.positions.size());
+        const int normalAccessor = test.addAccessor(test.addView(normals.data(), normals.size() * sizeof(glm::vec3)),
+                                                    0, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+                                                    normals.size());
+        const int indices = test.addIndices(grid.indices);
+        test.addPrimitive(indices, {{"POSITION", positions}, {"NORMAL", normalAccessor}});
+
+        const auto before = test.positionTriangles(indices, positions);
+        const auto stats = MeshOptimizer::Optimize(test.model);
+        check(stats.primitives == 1 && stats.fetchReordered == 1, "owned accessors: vertices not renumbered");
+        check(test.positionTriangles(indices, positions) == before, "owned accessors: triangles changed");
+        check(stats.acmrAfter <= stats.acmrBefore, "owned accessors: ACMR increased");
+    }
+
+    // Position and normal interleaved in a view holding another accessor, which renumbering would scramble
+    auto testInterleavedView() -> void
+    {
+        const auto grid = makeGrid(8, 2);
+        std::vector<glm::vec3> interleaved;
+        for (const auto& position : grid.positions)
+        {
+            interleaved.push_back(position);
+            interleaved.emplace_back(0.0f, 0.0f, 1.0f);
+        }
+        // Same stride, read by nothing in the primitive
+        for (size_t i = 0; i < 4; ++i)
+        {
+            interleaved.emplace_back(9.0f, 9.0f, 9.0f);
+            interleaved.emplace_back(8.0f, 8.0f, 8.0f);
+        }
+
+        TestModel test;
+        const int view = test.addView(interleaved.data(), interleaved.size() * sizeof(glm::vec3),
+                                      2 * sizeof(glm::vec3));
+        const int positions = test.addAccessor(view, 0, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+                                               grid.positions.size());
+        const int normals = test.addAccessor(view, sizeof(glm::vec3), TINYGLTF_COMPONENT_TYPE_FLOAT,
+                                             TINYGLTF_TYPE_VEC3, grid.positions.size());
+        test.addAccessor(view, grid.positions.size() * 2 * sizeof(glm::vec3), TINYGLTF_COMPONENT_TYPE_FLOAT,
+                         TINYGLTF_TYPE_VEC3, 4);
+        const int indices = test.addIndices(grid.indices);
+        test.addPrimitive(indices, {{"POSITION", positions}, {"NORMAL", normals}});
+
+        const auto vertexBytes = test.viewBytes(view);
+        const auto before = triangles(test.indices(indices));
+        const auto stats = MeshOptimizer::Optimize(test.model);
+        check(stats.primitives == 1 && stats.fetchReordered == 0, "interleaved view: vertices renumbered");
+        check(test.viewBytes(view) == vertexBytes, "interleaved view: vertex data changed");
+        check(triangles(test.indices(indices)) == before, "interleaved view: triangles changed");
+    }
+
+    // Two primitives drawing the same position accessor with their own indices
+    auto testSharedAccessor() -> void
+    {
+        const auto grid = makeGrid(8, 3);
+        const auto half = static_cast<std::ptrdiff_t>(grid.indices.size() / 6 * 3);
+        const std::vector<uint32_t> firstIndices(grid.indices.begin(), grid.indices.begin() + half);
+        const std::vector<uint32_t> secondIndices(grid.indices.begin() + half, grid.indices.end());
+
+        TestModel test;
+        const int view = test.addView(grid.positions.data(), grid.positions.size() * sizeof(glm::vec3));
+        const int positions = test.addAccessor(view, 0, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3,
+                                               grid.positions.size());
+        const int first = test.addIndices(firstIndices);
+        const int second = test.addIndices(secondIndices);
+        test.addPrimitive(first, {{"POSITION", positions}});
+        test.addPrimitive(second, {{"POSITION", positions}});
+
+        const auto vertexBytes = test.viewBytes(view);
+        const auto stats = MeshOptimizer::Optimize(test.model);
+        check(stats.primitives == 2 && stats.fetchReordered == 0, "shared accessor: vertices renumbered");
+        check(test.viewBytes(view) == vertexBytes, "shared accessor: vertex data changed");
+        check(triangles(test.indices(first)) == triangles(firstIndices), "shared accessor: first triangles changed");
+        check(triangles(test.indices(second)) == triangles(secondIndices),
+              "shared accessor: second triangles changed");
+    }
+}
+
+int main()
+{
+    testIndexPasses(4, 1);
+    testIndexPasses(32, 2);
+    testIndexPasses(64, 3);
+    testOwnedAccessors();
+    testInterleavedView();
+    testSharedAccessor();
+    return checkResult();
+}
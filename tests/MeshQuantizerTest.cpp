@@ -0,0 +1,266 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// Worst case errors of the attribute formats of MeshQuantizer, on inputs at the edges of each encoding.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Engine/MeshQuantizer.h"
+#include "glm/gtc/packing.hpp"
+
+// 16 bits octahedral normals, with the best of the four grid candidates, stay within a few thousandths of a degree
+static constexpr float MaxNormalErrorDegrees = 0.01f;
+static constexpr float MaxUnorm16Error = 0.5f / 65535.0f + 1e-7f;
+static constexpr float MaxUnorm8Error = 0.5f / 255.0f + 1e-7f;
+
+static auto angleDegrees(const glm::vec3& a, const glm::vec3& b) -> float
+{
+    // atan2 of the cross and dot products stays accurate for tiny angles, where acos of the dot product does not
+    const double ax = a.x, ay = a.y, az = a.z, bx = b.x, by = b.y, bz = b.z;
+    const double cross = std::hypot(ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx);
+    const double dot = ax * bx + ay * by + az * bz;
+    return static_cast<float>(std::atan2(cross, dot) * 180.0 / std::numbers::pi);
+}
+
+static auto checkNormal(const glm::vec3& normal, const float maxError, const std::string& label) -> void
+{
+    const glm::vec3 decoded = MeshQuantizer::DecodeOctahedral(MeshQuantizer::EncodeOctahedral(normal));
+    check(std::abs(glm::length(decoded) - 1.0f) <= 1e-5f, "decoded normal is not normalized: " + label);
+    check(angleDegrees(decoded, normal) <= maxError,
+          "normal error " + std::to_string(angleDegrees(decoded, normal)) + " degrees: " + label);
+}
+
+static auto testOctahedral() -> void
+{
+    // Axes are vertices of the octahedron, -Z is where the folded halves meet
+    const glm::vec3 axes[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    for (const auto& axis : axes)
+        checkNormal(axis, 1e-3f, "axis");
+    checkNormal({-0.0f, -0.0f, -1.0f}, 1e-3f, "-Z with negative zeros");
+
+    for (const float epsilon : {1e-7f, 1e-5f, 1e-3f, 1e-2f})
+    {
+        for (const float sx : {-1.0f, 1.0f})
+        {
+            for (const float sy : {-1.0f, 1.0f})
+            {
+                checkNormal({sx * epsilon, sy * epsilon, -1.0f}, MaxNormalErrorDegrees, "near -Z");
+                checkNormal({sx * epsilon, 0.0f, -1.0f}, MaxNormalErrorDegrees, "near -Z on an edge");
+                checkNormal({sx, sy, -epsilon}, MaxNormalErrorDegrees, "near the fold");
+                checkNormal({sx * (1.0f - epsilon), sy * epsilon, 0.0f}, MaxNormalErrorDegrees, "near an axis");
+            }
+        }
+    }
+
+    // Edges and faces of the octahedron
+    for (const float sx : {-1.0f, 0.0f, 1.0f})
+    {
+        for (const float sy : {-1.0f, 0.0f, 1.0f})
+        {
+            for (const float sz : {-1.0f, 0.0f, 1.0f})
+            {
+                if (sx != 0.0f || sy != 0.0f || sz != 0.0f)
+                    checkNormal({sx, sy, sz}, MaxNormalErrorDegrees, "diagonal");
+            }
+        }
+    }
+
+    std::mt19937 random(7);
+    std::normal_distribution<float> normal;
+    float maxError = 0.0f;
+    for (int i = 0; i < 200'000; ++i)
+    {
+        const glm::vec3 n(normal(random), normal(random), normal(random));
+        if (glm::length(n) < 1e-6f)
+            continue;
+        maxError = std::max(maxError, angleDegrees(MeshQuantizer::DecodeOctahedral(MeshQuantizer::EncodeOctahedral(n)),
+                                                   n));
+    }
+    check(maxError <= MaxNormalErrorDegrees, "random normals error " + std::to_string(maxError) + " degrees");
+
+    // Zero normals are kept as a fixed encoding rather than NaNs
+    const auto zero = MeshQuantizer::EncodeOctahedral({0, 0, 0});
+    check(zero[0] == 0 && zero[1] == 0, "zero normal");
+}
+
+/**
+ * Model with one primitive reading each accessor of floats as attribute
+ */
+struct TestModel
+{
+    tinygltf::Model model;
+
+    auto addAccessor(const std::string& attribute, const int type, const std::vector<float>& values) -> int
+    {
+        if (model.buffers.empty())
+        {
+            model.buffers.emplace_back();
+            model.meshes.emplace_back().primitives.emplace_back();
+        }
+
+        auto& data = model.buffers[0].data;
+        tinygltf::BufferView bufferView;
+        bufferView.buffer = 0;
+        bufferView.byteOffset = data.size();
+        bufferView.byteLength = values.size() * sizeof(float);
+        data.resize(data.size() + bufferView.byteLength);
+        std::memcpy(data.data() + bufferView.byteOffset, values.data(), bufferView.byteLength);
+
+        tinygltf::Accessor accessor;
+        accessor.bufferView = static_cast<int>(model.bufferViews.size());
+        accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+        accessor.type = type;
+        accessor.count = values.size() / tinygltf::GetNumComponentsInType(type);
+        model.bufferViews.push_back(bufferView);
+        model.accessors.push_back(accessor);
+
+        const int index = static_cast<int>(model.accessors.size()) - 1;
+        model.meshes[0].primitives[0].attributes[attribute] = index;
+        return index;
+    }
+
+    /**
+     * Component i of the quantized accessor, decoded like the vertex fetch does
+     */
+    [[nodiscard]] auto decoded(const int accessorIndex, const size_t i) const -> float
+    {
+        const auto& accessor = model.accessors[accessorIndex];
+        const auto& bufferView = model.bufferViews[accessor.bufferView];
+        const size_t componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+        const size_t componentSize = MeshQuantizer::ComponentSize(accessor.componentType);
+        const size_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : componentCount * componentSize;
+        const unsigned char* source = model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset +
+            accessor.byteOffset + (i / componentCount) * stride + (i % componentCount) * componentSize;
+
+        if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+            return glm::unpackUnorm1x8(*source);
+
+        uint16_t packed;
+        std::memcpy(&packed, source, sizeof(packed));
+        if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+            return glm::unpackUnorm1x16(packed);
+        if (accessor.componentType == MeshQuantizer::HalfFloatComponentType)
+            return glm::unpackHalf1x16(packed);
+        return glm::unpackSnorm1x16(packed);
+    }
+};
+
+static auto testTexCoords() -> void
+{
+    constexpr float max = MeshQuantizer::MaxHalfTexCoord;
+
+    // Everything in [0, 1] goes to unorm16, the bounds exactly
+    std::vector<float> unormValues = {0.0f, 1.0f, 0.5f, 1.0f / 65535.0f, 0.5f / 65535.0f, 1.0f - 0.5f / 65535.0f};
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < 10'000; ++i)
+        unormValues.push_back(unit(random));
+
+    TestModel unorm;
+    const int unormAccessor = unorm.addAccessor("TEXCOORD_0", TINYGLTF_TYPE_VEC2, unormValues);
+    MeshQuantizer::Quantize(unorm.model);
+    check(unorm.model.accessors[unormAccessor].componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+          unorm.model.accessors[unormAccessor].normalized, "texcoords in [0, 1] are not unorm16");
+    for (size_t i = 0; i < unormValues.size(); ++i)
+        check(std::abs(unorm.decoded(unormAccessor, i) - unormValues[i]) <= MaxUnorm16Error,
+              "unorm16 texcoord error at " + std::to_string(unormValues[i]));
+    check(unorm.decoded(unormAccessor, 0) == 0.0f && unorm.decoded(unormAccessor, 1) == 1.0f,
+          "unorm16 texcoords 0 and 1 are not exact");
+
+    // Past [0, 1], half floats up to the largest magnitude allowed
+    std::vector<float> halfValues = {0.0f, 1.0f, -1.0f, max, -max, max - 1e-3f, -max + 1e-3f, 1.5f, -0.25f};
+    std::uniform_real_distribution<float> wide(-max, max);
+    for (int i = 0; i < 10'000; ++i)
+        halfValues.push_back(wide(random));
+    if (halfValues.size() % 2 != 0)
+        halfValues.push_back(0.0f);
+
+    TestModel half;
+    const int halfAccessor = half.addAccessor("TEXCOORD_0", TINYGLTF_TYPE_VEC2, halfValues);
+    const auto halfStats = MeshQuantizer::Quantize(half.model);
+    check(half.model.accessors[halfAccessor].componentType == MeshQuantizer::HalfFloatComponentType,
+          "texcoords within MaxHalfTexCoord are not half floats");
+    for (size_t i = 0; i < halfValues.size(); ++i)
+    {
+        // Half floats keep 11 significant bits, rounding is within half a step
+        const float bound = std::max(std::abs(halfValues[i]) * std::ldexp(1.0f, -11), 1e-7f);
+        check(std::abs(half.decoded(halfAccessor, i) - halfValues[i]) <= bound,
+              "half texcoord error at " + std::to_string(halfValues[i]));
+    }
+    for (size_t i = 0; i < 5; ++i)
+        check(half.decoded(halfAccessor, i) == halfValues[i], "half texcoord " + std::to_string(halfValues[i]) +
+              " is not exact");
+    check(halfStats.maxTexCoordError <= max * std::ldexp(1.0f, -11), "reported half texcoord error");
+
+    // Past MaxHalfTexCoord the texcoords stay floats
+    TestModel outside;
+    const int outsideAccessor = outside.addAccessor("TEXCOORD_0", TINYGLTF_TYPE_VEC2, {0.0f, max + 0.5f});
+    MeshQuantizer::Quantize(outside.model);
+    check(outside.model.accessors[outsideAccessor].componentType == TINYGLTF_COMPONENT_TYPE_FLOAT,
+          "texcoords past MaxHalfTexCoord were quantized");
+}
+
+static auto testColors() -> void
+{
+    std::vector<float> values = {0.0f, 1.0f, 0.5f, 1.0f / 255.0f, 0.5f / 255.0f, 1.0f - 0.5f / 255.0f};
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    while (values.size() < 12'000)
+        values.push_back(unit(random));
+
+    for (const int type : {TINYGLTF_TYPE_VEC3, TINYGLTF_TYPE_VEC4})
+    {
+        TestModel colors;
+        const int accessorIndex = colors.addAccessor("COLOR_0", type, values);
+        MeshQuantizer::Quantize(colors.model);
+
+        const auto& accessor = colors.model.accessors[accessorIndex];
+        check(accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && accessor.normalized,
+              "colors are not unorm8");
+        check(colors.model.bufferViews[accessor.bufferView].byteStride == (type == TINYGLTF_TYPE_VEC3 ? 4u : 0u),
+              "vec3 colors do not keep a 4 bytes stride");
+        for (size_t i = 0; i < values.size(); ++i)
+            check(std::abs(colors.decoded(accessorIndex, i) - values[i]) <= MaxUnorm8Error,
+                  "unorm8 color error at " + std::to_string(values[i]));
+        check(colors.decoded(accessorIndex, 0) == 0.0f && colors.decoded(accessorIndex, 1) == 1.0f,
+              "unorm8 colors 0 and 1 are not exact");
+    }
+}
+
+static auto testQuantizedNormals() -> void
+{
+    std::vector<float> values = {0, 0, 1, 0, 0, -1, 1e-6f, -1e-6f, -1, 1, 0, 0, 0.577f, -0.577f, 0.577f};
+    TestModel normals;
+    const int accessorIndex = normals.addAccessor("NORMAL", TINYGLTF_TYPE_VEC3, values);
+    const auto stats = MeshQuantizer::Quantize(normals.model);
+
+    const auto& accessor = normals.model.accessors[accessorIndex];
+    check(accessor.type == TINYGLTF_TYPE_VEC2 && accessor.componentType == TINYGLTF_COMPONENT_TYPE_SHORT &&
+          accessor.normalized, "normals are not octahedral snorm16");
+    check(stats.maxNormalError <= MaxNormalErrorDegrees, "reported normal error");
+    for (size_t i = 0; i < accessor.count; ++i)
+    {
+        const std::array encoded{glm::packSnorm1x16(normals.decoded(accessorIndex, i * 2)),
+                                 glm::packSnorm1x16(normals.decoded(accessorIndex, i * 2 + 1))};
+        const glm::vec3 source(values[i * 3], values[i * 3 + 1], values[i * 3 + 2]);
+        check(angleDegrees(MeshQuantizer::DecodeOctahedral(encoded), source) <= MaxNormalErrorDegrees,
+              "quantized normal " + std::to_string(i));
+    }
+}
+
+int main()
+{
+    testOctahedral();
+    testTexCoords();
+    testColors();
+    testQuantizedNormals();
+    return checkResult();
+}
@@ -0,0 +1,303 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// The LOD levels only shrink, reuse the input vertices, and keep borders, seams and closed surfaces intact
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <numbers>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "Utility/MeshSimplifier.h"
+
+namespace
+{
+    constexpr std::array<float, 3> TriangleRatios{0.5f, 0.25f, 0.125f};
+
+    using Edge = std::pair<uint32_t, uint32_t>;
+
+    struct TestMesh
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> patches; // Per vertex, the vertices of a triangle must stay in one patch
+        std::vector<uint32_t> border; // Vertices on the open borders
+    };
+
+    /**
+     * Vertices numbered by position, copies on seams get the same number
+     */
+    auto weldPositions(const std::vector<glm::vec3>& positions) -> std::vector<uint32_t>
+    {
+        std::map<std::array<float, 3>, uint32_t> numbers;
+        std::vector<uint32_t> welded;
+        welded.reserve(positions.size());
+        for (const auto& position : positions)
+        {
+            const auto [it, inserted] = numbers.try_emplace({position.x, position.y, position.z},
+                                                            static_cast<uint32_t>(numbers.size()));
+            welded.push_back(it->second);
+        }
+        return welded;
+    }
+
+    /**
+     * Edges between welded positions not shared by exactly two triangles
+     */
+    auto openEdges(const std::vector<uint32_t>& welded, const std::vector<uint32_t>& indices) -> std::set<Edge>
+    {
+        std::map<Edge, int> counts;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t a = welded[indices[i + corner]];
+                const uint32_t b = welded[indices[i + (corner + 1) % 3]];
+                ++counts[std::minmax(a, b)];
+            }
+        }
+
+        std::set<Edge> edges;
+        for (const auto& [edge, count] : counts)
+        {
+            if (count != 2)
+                edges.insert(edge);
+        }
+        return edges;
+    }
+
+    /**
+     * Sphere of radius 1 without duplicated vertices, closed and curved everywhere
+     */
+    auto makeSphere(const uint32_t rings, const uint32_t segments) -> TestMesh
+    {
+        TestMesh mesh;
+        mesh.positions.emplace_back(0.0f, 1.0f, 0.0f);
+        for (uint32_t ring = 1; ring < rings; ++ring)
+        {
+            const float polar = std::numbers::pi_v<float> * static_cast<float>(ring) / static_cast<float>(rings);
+            for (uint32_t segment = 0; segment < segments; ++segment)
+            {
+                const float azimuth = 2.0f * std::numbers::pi_v<float> * static_cast<float>(segment) /
+                    static_cast<float>(segments);
+                mesh.positions.emplace_back(std::sin(polar) * std::cos(azimuth), std::cos(polar),
+                                            -std::sin(polar) * std::sin(azimuth));
+            }
+        }
+        mesh.positions.emplace_back(0.0f, -1.0f, 0.0f);
+
+        const auto ringVertex = [&](const uint32_t ring, const uint32_t segment)
+        {
+            return 1 + (ring - 1) * segments + segment % segments;
+        };
+        const uint32_t bottom = static_cast<uint32_t>(mesh.positions.size()) - 1;
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            mesh.indices.insert(mesh.indices.end(), {0, ringVertex(1, segment), ringVertex(1, segment + 1)});
+            mesh.indices.insert(mesh.indices.end(), {bottom, ringVertex(rings - 1, segment + 1),
+                                                     ringVertex(rings - 1, segment)});
+            for (uint32_t ring = 1; ring + 1 < rings; ++ring)
+            {
+                const uint32_t a = ringVertex(ring, segment);
+                const uint32_t b = ringVertex(ring, segment + 1);
+                const uint32_t c = ringVertex(ring + 1, segment);
+                const uint32_t d = ringVertex(ring + 1, segment + 1);
+                mesh.indices.insert(mesh.indices.end(), {a, c, d, a, d, b});
+            }
+        }
+        mesh.patches.assign(mesh.positions.size(), 0);
+        return mesh;
+    }
+
+    /**
+     * Box whose faces have their own vertices, as with per face normals, so every box edge is a seam
+     */
+    auto makeBox(const uint32_t size) -> TestMesh
+    {
+        TestMesh mesh;
+        for (uint32_t face = 0; face < 6; ++face)
+        {
+            const uint32_t axis = face / 2;
+            const bool positive = face % 2 == 1;
+            const uint32_t first = static_cast<uint32_t>(mesh.positions.size());
+            for (uint32_t v = 0; v <= size; ++v)
+            {
+                for (uint32_t u = 0; u <= size; ++u)
+                {
+                    // Integer coordinates first, copies of a vertex on two faces get bitwise equal positions
+                    std::array<uint32_t, 3> coordinates{};
+                    coordinates[axis] = positive ? size : 0;
+                    coordinates[(axis + 1) % 3] = u;
+                    coordinates[(axis + 2) % 3] = v;
+                    const float scale = 1.0f / static_cast<float>(size);
+                    mesh.positions.emplace_back(static_cast<float>(coordinates[0]) * scale,
+                                                static_cast<float>(coordinates[1]) * scale,
+                                                static_cast<float>(coordinates[2]) * scale);
+                    mesh.patches.push_back(face);
+                }
+            }
+
+            for (uint32_t v = 0; v < size; ++v)
+            {
+                for (uint32_t u = 0; u < size; ++u)
+                {
+                    const uint32_t a = first + v * (size + 1) + u;
+                    const uint32_t b = a + 1;
+                    const uint32_t c = a + size + 1;
+                    const uint32_t d = c + 1;
+                    if (positive)
+                        mesh.indices.insert(mesh.indices.end(), {a, b, d, a, d, c});
+                    else
+                        mesh.indices.insert(mesh.indices.end(), {a, d, b, a, c, d});
+                }
+            }
+        }
+        return mesh;
+    }
+
+    /**
+     * Open bumpy grid split in two halves along a seam column, each half with its own copy of the seam vertices
+     */
+    auto makeSplitGrid(const uint32_t size) -> TestMesh
+    {
+        TestMesh mesh;
+        const uint32_t seam = size / 2;
+        const uint32_t rowSizes[] = {seam + 1, size - seam + 1};
+        uint32_t first[2] = {0, 0};
+        for (uint32_t half = 0; half < 2; ++half)
+        {
+            first[half] = static_cast<uint32_t>(mesh.positions.size());
+            const uint32_t x0 = half == 0 ? 0 : seam;
+            for (uint32_t y = 0; y <= size; ++y)
+            {
+                for (uint32_t x = x0; x < x0 + rowSizes[half]; ++x)
+                {
+                    mesh.positions.emplace_back(x, y, std::sin(x * 0.5f) * std::cos(y * 0.3f) * 0.2f);
+                    mesh.patches.push_back(half);
+                    if (x == 0 || x == size || y == 0 || y == size)
+                        mesh.border.push_back(static_cast<uint32_t>(mesh.positions.size()) - 1);
+                }
+            }
+
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x + 1 < rowSizes[half]; ++x)
+                {
+                    const uint32_t a = first[half] + y * rowSizes[half] + x;
+                    const uint32_t b = a + 1;
+                    const uint32_t c = a + rowSizes[half];
+                    const uint32_t d = c + 1;
+                    mesh.indices.insert(mesh.indices.end(), {a, b, d, a, d, c});
+                }
+            }
+        }
+        return mesh;
+    }
+
+    /**
+     * Checks shared by every mesh, returns the triangle counts of the levels
+     */
+    auto checkLevels(const TestMesh& mesh, const std::vector<SimplifiedLevel>& levels, const float maxError,
+                     const std::string& label) -> std::vector<size_t>
+    {
+        const std::vector<uint32_t> welded = weldPositions(mesh.positions);
+        const std::set<Edge> sourceOpenEdges = openEdges(welded, mesh.indices);
+        const std::set<uint32_t> sourceVertices(mesh.indices.begin(), mesh.indices.end());
+
+        std::vector<size_t> triangleCounts;
+        size_t previousCount = mesh.indices.size() / 3;
+        float previousError = 0.0f;
+        for (size_t l = 0; l < levels.size(); ++l)
+        {
+            const auto& indices = levels[l].indices;
+            const std::string level = label + ", level " + std::to_string(l + 1);
+            const size_t triangleCount = indices.size() / 3;
+            triangleCounts.push_back(triangleCount);
+
+            check(indices.size() % 3 == 0 && triangleCount > 0, level + ": not a triangle list");
+            check(triangleCount < previousCount, level + ": " + std::to_string(triangleCount) +
+                  " triangles, previous level " + std::to_string(previousCount));
+            check(levels[l].error >= previousError && levels[l].error <= maxError,
+                  level + ": error " + std::to_string(levels[l].error));
+            previousCount = triangleCount;
+            previousError = levels[l].error;
+
+            check(std::ranges::all_of(indices, [&](const uint32_t v) { return sourceVertices.contains(v); }),
+                  level + ": index not in the source");
+
+            bool samePatch = true;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                samePatch &= mesh.patches[indices[i]] == mesh.patches[indices[i + 1]] &&
+                    mesh.patches[indices[i]] == mesh.patches[indices[i + 2]];
+            }
+            check(samePatch, level + ": a triangle mixes vertices across a seam");
+
+            // Borders are locked and seam vertices move together, no hole opens and no border moves
+            check(openEdges(welded, indices) == sourceOpenEdges, level + ": open edges changed");
+
+            const std::set<uint32_t> used(indices.begin(), indices.end());
+            check(std::ranges::all_of(mesh.border, [&](const uint32_t v) { return used.contains(v); }),
+                  level + ": border vertex collapsed");
+        }
+        return triangleCounts;
+    }
+
+    auto testMesh(const TestMesh& mesh, const std::string& label) -> void
+    {
+        const size_t triangleCount = mesh.indices.size() / 3;
+        const auto levels = simplifyMeshLevels(mesh.positions, mesh.indices, TriangleRatios, 1.0f);
+        const auto counts = checkLevels(mesh, levels, 1.0f, label);
+
+        // A loose limit reaches the ratios until the locked vertices leave nothing to collapse
+        check(!counts.empty(), label + ": no level");
+        for (size_t l = 0; l < counts.size(); ++l)
+        {
+            const auto target = static_cast<size_t>(static_cast<float>(triangleCount) * TriangleRatios[l]);
+            check(counts[l] <= target || l + 1 == counts.size(),
+                  label + ", level " + std::to_string(l + 1) + ": ratio not reached");
+        }
+    }
+
+    auto testErrorLimit() -> void
+    {
+        const TestMesh sphere = makeSphere(12, 24);
+        const size_t triangleCount = sphere.indices.size() / 3;
+
+        const auto loose = simplifyMeshLevels(sphere.positions, sphere.indices, TriangleRatios, 1.0f);
+        checkLevels(sphere, loose, 1.0f, "sphere, loose limit");
+        if (!check(loose.size() == TriangleRatios.size() && loose[0].error > 0.0f,
+                   "sphere, loose limit: " + std::to_string(loose.size()) + " levels"))
+            return;
+
+        // Below the error the first level needed, it can't be reached
+        const float maxError = loose[0].error * 0.5f;
+        const auto tight = simplifyMeshLevels(sphere.positions, sphere.indices, TriangleRatios, maxError);
+        const auto counts = checkLevels(sphere, tight, maxError, "sphere, tight limit");
+        check(counts.size() <= 1, "sphere, tight limit: " + std::to_string(counts.size()) + " levels");
+        if (!counts.empty())
+        {
+            check(counts[0] > static_cast<size_t>(static_cast<float>(triangleCount) * TriangleRatios[0]),
+                  "sphere, tight limit: first ratio reached");
+        }
+
+        check(simplifyMeshLevels(sphere.positions, sphere.indices, TriangleRatios, 0.0f).empty(),
+              "sphere, no error allowed: levels generated");
+    }
+}
+
+int main()
+{
+    testMesh(makeSphere(12, 24), "sphere");
+    testMesh(makeBox(6), "box");
+    testMesh(makeSplitGrid(16), "split grid");
+    testErrorLimit();
+    return checkResult();
+}
@@ -0,0 +1,456 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// A cooked model reads back as it was written, and only while its sources, options and file are unchanged
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Check.h"
+#include "Engine/ModelCache.h"
+#include "Utility/CacheFile.h"
+
+namespace
+{
+    using Bytes = std::vector<unsigned char>;
+
+    auto writeFile(const std::filesystem::path& path, const Bytes& bytes) -> void
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    auto readFile(const std::filesystem::path& path) -> Bytes
+    {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    /**
+     * The .gltf, an external buffer with a space in its name, and an external image
+     */
+    struct Sources
+    {
+        std::filesystem::path directory;
+        std::filesystem::path gltf;
+        std::filesystem::path buffer;
+        std::filesystem::path image;
+        std::string cache;
+    };
+
+    auto makeSources(const std::filesystem::path& directory) -> Sources
+    {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        Sources sources{
+            .directory = directory,
+            .gltf = directory / "model.gltf",
+            .buffer = directory / "mesh data.bin",
+            .image = directory / "skin.png",
+            .cache = (directory / "model.gltf.cooked").string(),
+        };
+
+        const std::string json = R"({"asset":{"version":"2.0"}})";
+        writeFile(sources.gltf, Bytes(json.begin(), json.end()));
+        Bytes buffer(96);
+        std::iota(buffer.begin(), buffer.end(), 0);
+        writeFile(sources.buffer, buffer);
+        writeFile(sources.image, Bytes(64, 0x89));
+        return sources;
+    }
+
+    auto addBufferView(tinygltf::Model& model, const int buffer, const size_t byteOffset, const size_t byteLength,
+                       const size_t byteStride, const int target) -> void
+    {
+        tinygltf::BufferView& view = model.bufferViews.emplace_back();
+        view.name = "view " + std::to_string(model.bufferViews.size() - 1);
+        view.buffer = buffer;
+        view.byteOffset = byteOffset;
+        view.byteLength = byteLength;
+        view.byteStride = byteStride;
+        view.target = target;
+    }
+
+    auto addAccessor(tinygltf::Model& model, const int bufferView, const size_t byteOffset, const int componentType,
+                     const size_t count, const int type, std::vector<double> minValues = {},
+                     std::vector<double> maxValues = {}) -> void
+    {
+        tinygltf::Accessor& accessor = model.accessors.emplace_back();
+        accessor.name = "accessor " + std::to_string(model.accessors.size() - 1);
+        accessor.bufferView = bufferView;
+        accessor.byteOffset = byteOffset;
+        accessor.componentType = componentType;
+        accessor.normalized = componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        accessor.count = count;
+        accessor.type = type;
+        accessor.minValues = std::move(minValues);
+        accessor.maxValues = std::move(maxValues);
+    }
+
+    /**
+     * A small model using every part the cache stores, buffer 1 has no URI as when an import pass adds it
+     */
+    auto makeModel() -> tinygltf::Model
+    {
+        tinygltf::Model model;
+        model.buffers.resize(2);
+        model.buffers[0].name = "geometry";
+        model.buffers[0].uri = "mesh%20data.bin";
+        model.buffers[0].data.resize(96);
+        std::iota(model.buffers[0].data.begin(), model.buffers[0].data.end(), 0);
+        // An odd size, the next blob must still start aligned
+        model.buffers[1].name = "quantized";
+        model.buffers[1].data = {1, 2, 3, 4, 5, 6, 7};
+
+        addBufferView(model, 0, 0, 48, 12, TINYGLTF_TARGET_ARRAY_BUFFER);
+        addBufferView(model, 0, 48, 12, 0, TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+        addBufferView(model, 0, 60, 36, 0, 0);
+        addBufferView(model, 1, 0, 7, 0, TINYGLTF_TARGET_ARRAY_BUFFER);
+        addAccessor(model, 0, 0, TINYGLTF_COMPONENT_TYPE_FLOAT, 4, TINYGLTF_TYPE_VEC3, {0, 0, 0}, {1, 1, 0});
+        addAccessor(model, 1, 0, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 6, TINYGLTF_TYPE_SCALAR);
+        addAccessor(model, 2, 0, TINYGLTF_COMPONENT_TYPE_FLOAT, 3, TINYGLTF_TYPE_SCALAR, {0}, {2});
+        addAccessor(model, 2, 12, TINYGLTF_COMPONENT_TYPE_FLOAT, 2, TINYGLTF_TYPE_VEC3);
+        addAccessor(model, 3, 0, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 1, TINYGLTF_TYPE_VEC4);
+
+        tinygltf::Primitive primitive;
+        primitive.attributes = {{"POSITION", 0}, {"COLOR_0", 4}};
+        primitive.targets = {{{"POSITION", 3}}};
+        primitive.indices = 1;
+        primitive.material = 0;
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+        model.meshes.resize(1);
+        model.meshes[0].name = "quad";
+        model.meshes[0].primitives = {primitive};
+        model.meshes[0].weights = {0.25};
+
+        model.nodes.resize(2);
+        model.nodes[0].name = "root";
+        model.nodes[0].children = {1};
+        model.nodes[0].translation = {1, 2, 3};
+        model.nodes[0].rotation = {0, 0.6, 0, 0.8};
+        model.nodes[0].scale = {2, 2, 2};
+        model.nodes[1].name = "quad";
+        model.nodes[1].mesh = 0;
+        model.nodes[1].matrix = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 4, 5, 6, 1};
+        model.nodes[1].weights = {0.5};
+
+        model.animations.resize(1);
+        model.animations[0].name = "slide";
+        model.animations[0].samplers.resize(1);
+        model.animations[0].samplers[0].input = 2;
+        model.animations[0].samplers[0].output = 3;
+        model.animations[0].samplers[0].interpolation = "STEP";
+        model.animations[0].channels.resize(1);
+        model.animations[0].channels[0].sampler = 0;
+        model.animations[0].channels[0].target_node = 1;
+        model.animations[0].channels[0].target_path = "translation";
+
+        model.images.resize(1);
+        model.images[0].name = "skin";
+        model.images[0].uri = "skin.png";
+        model.images[0].width = 2;
+        model.images[0].height = 2;
+        model.images[0].component = 4;
+        model.images[0].bits = 8;
+        model.images[0].pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        model.images[0].image.resize(16);
+        std::iota(model.images[0].image.begin(), model.images[0].image.end(), 100);
+
+        model.samplers.resize(1);
+        model.textures.resize(1);
+        model.textures[0].sampler = 0;
+        model.textures[0].source = 0;
+        model.materials.resize(1);
+        model.materials[0].name = "skin";
+        model.materials[0].pbrMetallicRoughness.baseColorTexture.index = 0;
+
+        model.scenes.resize(1);
+        model.scenes[0].nodes = {0};
+        model.defaultScene = 0;
+        return model;
+    }
+
+    auto makeLods() -> MeshLods
+    {
+        MeshLods lods;
+        lods.indices = {0, 1, 2, 0, 2, 3, 0, 1, 3};
+        lods.primitives.resize(1);
+        lods.primitives[0].mesh = 0;
+        lods.primitives[0].primitive = 0;
+        lods.primitives[0].levels = {
+            {.indexCount = 6, .byteOffset = 0, .firstIndex = 0, .error = 0.0f},
+            {.indexCount = 3, .byteOffset = 24, .firstIndex = 6, .error = 0.125f},
+        };
+        return lods;
+    }
+
+    auto same(const tinygltf::BufferView& a, const tinygltf::BufferView& b) -> bool
+    {
+        return std::tie(a.name, a.buffer, a.byteOffset, a.byteLength, a.byteStride, a.target) ==
+            std::tie(b.name, b.buffer, b.byteOffset, b.byteLength, b.byteStride, b.target);
+    }
+
+    auto same(const tinygltf::Accessor& a, const tinygltf::Accessor& b) -> bool
+    {
+        return std::tie(a.name, a.bufferView, a.byteOffset, a.normalized, a.componentType, a.count, a.type,
+                        a.minValues, a.maxValues) ==
+            std::tie(b.name, b.bufferView, b.byteOffset, b.normalized, b.componentType, b.count, b.type,
+                     b.minValues, b.maxValues);
+    }
+
+    auto same(const tinygltf::Primitive& a, const tinygltf::Primitive& b) -> bool
+    {
+        return std::tie(a.attributes, a.targets, a.material, a.indices, a.mode) ==
+            std::tie(b.attributes, b.targets, b.material, b.indices, b.mode);
+    }
+
+    auto same(const tinygltf::Node& a, const tinygltf::Node& b) -> bool
+    {
+        return std::tie(a.name, a.mesh, a.skin, a.children, a.translation, a.rotation, a.scale, a.matrix,
+                        a.weights) ==
+            std::tie(b.name, b.mesh, b.skin, b.children, b.translation, b.rotation, b.scale, b.matrix, b.weights);
+    }
+
+    auto same(const tinygltf::AnimationChannel& a, const tinygltf::AnimationChannel& b) -> bool
+    {
+        return std::tie(a.sampler, a.target_node, a.target_path) == std::tie(b.sampler, b.target_node, b.target_path);
+    }
+
+    auto same(const tinygltf::AnimationSampler& a, const tinygltf::AnimationSampler& b) -> bool
+    {
+        return std::tie(a.input, a.output, a.interpolation) == std::tie(b.input, b.output, b.interpolation);
+    }
+
+    // The source URI is not kept, the pixels are already decoded
+    auto same(const tinygltf::Image& a, const tinygltf::Image& b) -> bool
+    {
+        return std::tie(a.name, a.width, a.height, a.component, a.bits, a.pixel_type, a.image) ==
+            std::tie(b.name, b.width, b.height, b.component, b.bits, b.pixel_type, b.image);
+    }
+
+    auto same(const PrimitiveLod& a, const PrimitiveLod& b) -> bool
+    {
+        return std::tie(a.indexCount, a.byteOffset, a.firstIndex, a.error) ==
+            std::tie(b.indexCount, b.byteOffset, b.firstIndex, b.error);
+    }
+
+    // Defined after every element overload, its calls don't find later ones by argument dependent lookup
+    template <typename T>
+    auto same(const std::vector<T>& a, const std::vector<T>& b) -> bool;
+
+    auto same(const tinygltf::Mesh& a, const tinygltf::Mesh& b) -> bool
+    {
+        return a.name == b.name && a.weights == b.weights && same(a.primitives, b.primitives);
+    }
+
+    auto same(const tinygltf::Animation& a, const tinygltf::Animation& b) -> bool
+    {
+        return a.name == b.name && same(a.channels, b.channels) && same(a.samplers, b.samplers);
+    }
+
+    auto same(const PrimitiveLods& a, const PrimitiveLods& b) -> bool
+    {
+        return a.mesh == b.mesh && a.primitive == b.primitive && same(a.levels, b.levels);
+    }
+
+    template <typename T>
+    auto same(const std::vector<T>& a, const std::vector<T>& b) -> bool
+    {
+        return std::ranges::equal(a, b, [](const T& x, const T& y) { return same(x, y); });
+    }
+
+    auto readCache(const std::string& cachePath, const MeshOptions& options, tinygltf::Model& model,
+                   MeshLods& lods, ModelBuffers& buffers) -> bool
+    {
+        std::string log;
+        return ModelCache::Read(cachePath, options, model, lods, buffers, log);
+    }
+
+    auto readCache(const std::string& cachePath, const MeshOptions& options) -> bool
+    {
+        tinygltf::Model model;
+        MeshLods lods;
+        ModelBuffers buffers;
+        return readCache(cachePath, options, model, lods, buffers);
+    }
+
+    auto testRoundTrip(const Sources& sources, const MeshOptions& options, const bool mapBuffers) -> void
+    {
+        const std::string label = mapBuffers ? "mapped buffers" : "copied buffers";
+        const tinygltf::Model written = makeModel();
+        const MeshLods writtenLods = makeLods();
+        check(ModelCache::Write(sources.cache, sources.gltf.string(), options, written, writtenLods),
+              label + ": write, with a percent-encoded buffer URI");
+
+        MeshOptions readOptions = options;
+        readOptions.mapBuffers = mapBuffers;
+        tinygltf::Model model;
+        MeshLods lods;
+        ModelBuffers buffers;
+        if (!check(readCache(sources.cache, readOptions, model, lods, buffers), label + ": read"))
+            return;
+
+        check(same(model.bufferViews, written.bufferViews), label + ": buffer views");
+        check(same(model.accessors, written.accessors), label + ": accessors");
+        check(same(model.meshes, written.meshes), label + ": meshes");
+        check(same(model.nodes, written.nodes), label + ": nodes");
+        check(same(model.animations, written.animations), label + ": animations");
+        check(same(model.images, written.images), label + ": images");
+        check(model.scenes.size() == 1 && model.scenes[0].nodes == written.scenes[0].nodes &&
+              model.defaultScene == written.defaultScene, label + ": scenes");
+        check(lods.indices == writtenLods.indices && same(lods.primitives, writtenLods.primitives), label + ": LODs");
+
+        if (!check(model.buffers.size() == written.buffers.size(), label + ": buffer count"))
+            return;
+        for (size_t i = 0; i < written.buffers.size(); ++i)
+        {
+            const std::string buffer = label + ", buffer " + std::to_string(i);
+            const auto bytes = buffers[i];
+            check(model.buffers[i].name == written.buffers[i].name, buffer + ": name");
+            check(std::ranges::equal(bytes, written.buffers[i].data), buffer + ": bytes");
+            check(model.buffers[i].data.empty() == mapBuffers, buffer + ": vector left empty only when mapped");
+            check(reinterpret_cast<uintptr_t>(bytes.data()) % CacheFile::BlobAlignment == 0, buffer + ": alignment");
+        }
+        check((buffers.mappedBytes() != 0) == mapBuffers, label + ": mapping kept only when mapped");
+    }
+
+    /**
+     * The cache is written, change alters the sources, then the cache must read back as fresh or not
+     */
+    template <typename Change>
+    auto testSources(const std::filesystem::path& directory, const std::string& label, const bool fresh,
+                     Change change) -> void
+    {
+        const Sources sources = makeSources(directory);
+        const MeshOptions options{.generateLods = true};
+        if (!check(ModelCache::Write(sources.cache, sources.gltf.string(), options, makeModel(), makeLods()),
+                   label + ": write"))
+            return;
+
+        change(sources);
+        check(readCache(sources.cache, options) == fresh, label + (fresh ? ": stale" : ": still read"));
+    }
+
+    auto testInvalidation(const std::filesystem::path& directory) -> void
+    {
+        using namespace std::chrono_literals;
+        const auto touch = [](const std::filesystem::path& path)
+        {
+            std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + 1h);
+        };
+        const auto rewrite = [](const std::filesystem::path& path, const Bytes& bytes)
+        {
+            // Put back the original time, only the content may tell the change
+            const auto time = std::filesystem::last_write_time(path);
+            writeFile(path, bytes);
+            std::filesystem::last_write_time(path, time);
+        };
+
+        testSources(directory, "unchanged", true, [](const Sources&) {});
+        testSources(directory, "touched .gltf", true, [&](const Sources& sources) { touch(sources.gltf); });
+        testSources(directory, "touched buffer", true, [&](const Sources& sources) { touch(sources.buffer); });
+        testSources(directory, "buffer of another size, same time", false, [&](const Sources& sources)
+        {
+            Bytes bytes = readFile(sources.buffer);
+            bytes.push_back(0);
+            rewrite(sources.buffer, bytes);
+        });
+        testSources(directory, "buffer edited, same size", false, [&](const Sources& sources)
+        {
+            Bytes bytes = readFile(sources.buffer);
+            bytes[10] ^= 0xFF;
+            rewrite(sources.buffer, bytes);
+            touch(sources.buffer);
+        });
+        testSources(directory, "image edited, same size", false, [&](const Sources& sources)
+        {
+            rewrite(sources.image, Bytes(64, 0x42));
+            touch(sources.image);
+        });
+        testSources(directory, ".gltf edited, same size", false, [&](const Sources& sources)
+        {
+            Bytes bytes = readFile(sources.gltf);
+            bytes.back() = ' ';
+            rewrite(sources.gltf, bytes);
+            touch(sources.gltf);
+        });
+        testSources(directory, "buffer removed", false, [](const Sources& sources)
+        {
+            std::filesystem::remove(sources.buffer);
+        });
+    }
+
+    auto testRejected(const std::filesystem::path& directory) -> void
+    {
+        const Sources sources = makeSources(directory);
+        const MeshOptions options{.generateLods = true, .optimizeIndices = true};
+        if (!check(ModelCache::Write(sources.cache, sources.gltf.string(), options, makeModel(), makeLods()),
+                   "options: write"))
+            return;
+
+        // Only the options changing what is cooked matter
+        check(readCache(sources.cache, {.mergeBuffers = true, .generateLods = true, .optimizeIndices = true}),
+              "options: merged buffers");
+        check(!readCache(sources.cache, {.generateLods = false, .optimizeIndices = true}), "options: without LODs");
+        check(!readCache(sources.cache, {.generateLods = true, .optimizeIndices = false}),
+              "options: without index optimization");
+        check(!readCache(sources.cache, {.generateLods = true, .optimizeIndices = true, .quantizeAttributes = true}),
+              "options: with quantization");
+
+        const Bytes bytes = readFile(sources.cache);
+        for (size_t size = 0; size < bytes.size(); ++size)
+        {
+            writeFile(sources.cache, Bytes(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(size)));
+            tinygltf::Model model;
+            MeshLods lods;
+            ModelBuffers buffers;
+            const std::string label = "truncated to " + std::to_string(size) + " of " + std::to_string(bytes.size());
+            check(!readCache(sources.cache, options, model, lods, buffers), label);
+            check(model.accessors.empty() && lods.indices.empty(), label + ": outputs untouched");
+        }
+
+        Bytes longer = bytes;
+        longer.push_back(0);
+        writeFile(sources.cache, longer);
+        check(!readCache(sources.cache, options), "trailing byte");
+
+        Bytes otherVersion = bytes;
+        ++otherVersion[4];
+        writeFile(sources.cache, otherVersion);
+        check(!readCache(sources.cache, options), "other version");
+
+        writeFile(sources.cache, bytes);
+        check(readCache(sources.cache, options), "restored");
+
+        // The engine ignores sparse data, such models are never cooked
+        std::filesystem::remove(sources.cache);
+        tinygltf::Model sparse = makeModel();
+        sparse.accessors[3].sparse.isSparse = true;
+        check(!ModelCache::Write(sources.cache, sources.gltf.string(), options, sparse, makeLods()), "sparse: write");
+        check(!std::filesystem::exists(sources.cache), "sparse: no cache file");
+    }
+}
+
+int main()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "HumanGLModelCacheTest";
+
+    const Sources sources = makeSources(directory);
+    testRoundTrip(sources, {.generateLods = true, .quantizeAttributes = true}, false);
+    testRoundTrip(sources, {.generateLods = true, .quantizeAttributes = true}, true);
+    testInvalidation(directory);
+    testRejected(directory);
+
+    std::filesystem::remove_all(directory);
+    return checkResult();
+}
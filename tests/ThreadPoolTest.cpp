@@ -0,0 +1,114 @@
+//
+// Created by Simon Cros on 10/18/26.
+//
+
+// parallelFor called from tasks while every worker is busy, as loadModelAsync does when a model decodes its images
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <latch>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Utility/ThreadPool.h"
+
+namespace
+{
+    constexpr auto Timeout = std::chrono::seconds(20);
+
+    /**
+     * A deadlocked pool can't be joined, the test fails without destroying it
+     */
+    template <typename T>
+    auto waitOrExit(std::future<T>& future, const std::string& label) -> void
+    {
+        if (future.wait_for(Timeout) == std::future_status::ready)
+            return;
+
+        std::cout << label << ": deadlocked" << std::endl;
+        std::_Exit(1);
+    }
+
+    using Counters = std::vector<std::atomic<int>>;
+
+    auto checkOnce(const Counters& counters, const std::string& label) -> void
+    {
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            const int runs = counters[i].load();
+            check(runs == 1, label + ": index " + std::to_string(i) + " ran " + std::to_string(runs) + " times");
+        }
+    }
+
+    /**
+     * taskCount tasks each run a parallelFor of count indices, the first threadCount tasks hold every worker until
+     * they all started so the nested loops can't rely on an idle worker
+     */
+    auto testSaturated(const size_t threadCount, const size_t taskCount, const size_t count, const bool nested) -> void
+    {
+        const std::string label = std::to_string(threadCount) + " workers, " + std::to_string(taskCount) + " tasks, " +
+            std::to_string(count) + " indices" + (nested ? ", nested" : "");
+
+        // Heap allocated so an exit on deadlock doesn't destroy them under running workers
+        auto* pool = new ThreadPool(threadCount);
+        auto started = std::make_shared<std::latch>(static_cast<std::ptrdiff_t>(threadCount));
+        std::vector<std::unique_ptr<Counters>> counters;
+        std::vector<std::future<void>> tasks;
+
+        for (size_t task = 0; task < taskCount; ++task)
+        {
+            const size_t innerCount = nested ? 3 : 1;
+            counters.push_back(std::make_unique<Counters>(count * innerCount));
+            tasks.push_back(pool->submit([pool, started, task, threadCount, count, innerCount,
+                                          &taskCounters = *counters.back()]
+            {
+                if (task < threadCount)
+                    started->arrive_and_wait();
+
+                pool->parallelFor(count, [&](const size_t i)
+                {
+                    if (innerCount == 1)
+                    {
+                        ++taskCounters[i];
+                        return;
+                    }
+
+                    // A loop inside a loop body, the caller may itself be a helper of the outer loop
+                    pool->parallelFor(innerCount, [&](const size_t j) { ++taskCounters[i * innerCount + j]; });
+                });
+            }));
+        }
+
+        for (size_t task = 0; task < taskCount; ++task)
+        {
+            waitOrExit(tasks[task], label);
+            checkOnce(*counters[task], label + ", task " + std::to_string(task));
+        }
+        delete pool;
+    }
+}
+
+int main()
+{
+    for (const size_t threadCount : {1u, 2u, 4u})
+    {
+        for (const size_t count : {0u, 1u, 2u, 7u, 1000u})
+        {
+            testSaturated(threadCount, threadCount, count, false);
+            testSaturated(threadCount, threadCount * 3, count, false);
+        }
+        testSaturated(threadCount, threadCount * 2, 100, true);
+    }
+
+    // From the thread owning the pool, with idle workers
+    ThreadPool pool(3);
+    Counters counters(10'000);
+    pool.parallelFor(counters.size(), [&](const size_t i) { ++counters[i]; });
+    checkOnce(counters, "main thread");
+
+    return checkResult();
+}